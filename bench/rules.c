@@ -0,0 +1,286 @@
+// Micro-benchmarks for the rules in solitaire.h, built and run by `./nob bench-rules`.
+//
+// Every case runs a warmup pass, then BENCH_REPS timed repetitions of `ops`
+// operations each, and reports the median and spread of ns/op over the
+// repetitions. Change Card/Pile, rerun, compare.
+#define SOLITAIRE_IMPLEMENTATION
+#include "solitaire.h"
+#define SOLITAIRE_BATCH_IMPLEMENTATION
+#include "solitaire_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_REPS 15
+#define BENCH_DEALS 1024 // distinct deals the move-finding and playout cases cycle through
+#define PLAYOUT_MAX_MOVES 1000 // random play loops forever otherwise
+#define PLAYOUT_STALL_MOVES 150 // same cutoff as tools/sim.c: moves without progress before a game counts as stuck
+#define CHECK_ROUNDS 256 // batches of played-out positions the batch targets are checked on
+
+// results land here so the compiler can't drop the work
+static volatile uint64_t sink;
+
+static Game deals[BENCH_DEALS];
+static Game_Batch batches[BENCH_DEALS/GAME_BATCH]; // the same deals, GAME_BATCH per batch
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+typedef uint64_t (*Bench_Fn)(size_t ops);
+
+// times `fn` and prints ns/op, returns the median ns/op
+static double bench(const char *name, Bench_Fn fn, size_t ops)
+{
+    double ns_per_op[BENCH_REPS];
+    sink += fn(ops/4 + 1); // warmup: caches, branch predictors, page faults
+    for (size_t r = 0; r < BENCH_REPS; r++) {
+        double start = now_ns();
+        sink += fn(ops);
+        ns_per_op[r] = (now_ns() - start)/ops;
+    }
+    qsort(ns_per_op, BENCH_REPS, sizeof(*ns_per_op), cmp_double);
+    double median = ns_per_op[BENCH_REPS/2];
+    printf("%-20s %10.2f ns/op  (min %8.2f, max %8.2f, %zu ops x %d reps)\n",
+           name, median, ns_per_op[0], ns_per_op[BENCH_REPS-1], ops, BENCH_REPS);
+    return median;
+}
+
+static uint64_t bench_pile_split(size_t ops)
+{
+    Game game = deals[0];
+    Pile *src = &game.reserve;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        size_t split = i % src->count;
+        int count = src->count;
+        Pile_View run = pile_split(game.cards, src, split);
+        src->count = count; // the cards are still there, just put them back
+        acc += run.count;
+    }
+    return acc;
+}
+
+static uint64_t bench_pile_append_many(size_t ops)
+{
+    Game game = deals[0];
+    Card arena[8 + 13];
+    Pile dst = { 0, 0, 8 + 13 };
+    uint64_t acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        dst.count = i % 8;
+        pile_append_many(arena, &dst, pile_view(game.cards, &game.reserve, 0, 1 + i % 13));
+        acc += dst.count;
+    }
+    return acc;
+}
+
+// one op = one tap on a tableau card of some deal
+static uint64_t bench_find_move_target(size_t ops)
+{
+    uint64_t acc = 0;
+    Pile_Ref target;
+    for (size_t i = 0; i < ops; i++) {
+        Game *game = &deals[i % BENCH_DEALS];
+        Pile *p = &game->tableau[i % TABLEAU_COLS];
+        size_t j = (i/TABLEAU_COLS) % p->count;
+        if (findMoveTarget(game, pile_view(game->cards, p, j, p->count-j), &target)) acc += target.index + 1;
+    }
+    return acc;
+}
+
+// same taps as bench_find_move_target, GAME_BATCH lanes at a time
+static uint64_t bench_batch_targets(size_t ops)
+{
+    uint64_t acc = 0;
+    Card_Batch candidates;
+    uint16_t accepts[BATCH_PILES];
+    int8_t first[GAME_BATCH];
+    batch_clear_candidates(&candidates);
+    for (size_t i = 0; i < ops; i += GAME_BATCH) {
+        const Game_Batch *b = &batches[(i % BENCH_DEALS)/GAME_BATCH];
+        for (size_t lane = 0; lane < GAME_BATCH; lane++) {
+            size_t k = i + lane;
+            Game *game = &deals[k % BENCH_DEALS];
+            Pile *p = &game->tableau[k % TABLEAU_COLS];
+            size_t j = (k/TABLEAU_COLS) % p->count;
+            batch_set_candidate(&candidates, lane, pile_view(game->cards, p, j, p->count-j));
+        }
+        batch_accepts(b, &candidates, accepts);
+        uint16_t found = batch_first_targets(accepts, first);
+        while (found) {
+            acc += batch_pile_ref(first[__builtin_ctz(found)]).index + 1;
+            found &= found - 1;
+        }
+    }
+    return acc;
+}
+
+static uint64_t bench_deal(size_t ops)
+{
+    Game game;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < ops; i++) {
+        dealGame(&game, i);
+        acc += pile_first(game.cards, &game.reserve).value;
+    }
+    return acc;
+}
+
+static uint64_t playout_moves;
+static uint64_t playout_wins;
+static uint64_t playout_capped; // games that hit PLAYOUT_MAX_MOVES rather than stalling
+
+// one op = one draw-1 game played with uniformly random moves until it is
+// won, stuck, goes PLAYOUT_STALL_MOVES without progress or hits PLAYOUT_MAX_MOVES.
+// Progress is what it is in tools/sim.c: a card turned over or a new high on
+// the foundations; anything else can be undone and cycle forever.
+static uint64_t bench_playout(size_t ops)
+{
+    Move moves[MAX_MOVES];
+    uint64_t rng = 0x5EED;
+    playout_moves = 0;
+    playout_wins = 0;
+    playout_capped = 0;
+    for (size_t i = 0; i < ops; i++) {
+        Game game = deals[i % BENCH_DEALS];
+        int foundation_cards = 0, best_foundation_cards = 0;
+        size_t m = 0, progress_at = 0;
+        for (; m < PLAYOUT_MAX_MOVES && m - progress_at < PLAYOUT_STALL_MOVES; m++) {
+            size_t n = listMoves_draw1(&game, moves);
+            if (n == 0) break;
+            Move move = moves[rng_below(&rng, n)];
+            bool progress = revealsCard(&game, move);
+            if (move.to.kind == PILE_FOUNDATION) foundation_cards++;
+            if (move.from.kind == PILE_FOUNDATION) foundation_cards--;
+            if (foundation_cards > best_foundation_cards) {
+                best_foundation_cards = foundation_cards;
+                progress = true;
+            }
+            applyMove_draw1(&game, move);
+            if (progress) progress_at = m + 1;
+        }
+        playout_moves += m;
+        playout_wins += isWon(&game);
+        playout_capped += m == PLAYOUT_MAX_MOVES;
+    }
+    return playout_moves;
+}
+
+// tableau runs from every card, then the talon top; returns how many
+static size_t list_candidates(Game *game, Pile_View *out)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < TABLEAU_COLS; i++) {
+        Pile *p = &game->tableau[i];
+        for (size_t j = 0; j < p->count; j++) out[n++] = pile_view(game->cards, p, j, p->count-j);
+    }
+    if (game->talon.count > 0) out[n++] = pile_view(game->cards, &game->talon, game->talon.count-1, 1);
+    return n;
+}
+
+// Checks batch_first_targets() lane by lane against findMoveTarget(), on deals
+// advanced by random playouts of random length so foundations get started and
+// columns emptied; half the time a playout takes a foundation move when there
+// is one, or the foundations would hardly grow. Stops at the first lane that
+// disagrees.
+static bool check_batch_targets(void)
+{
+    static Pile_View candidates[GAME_BATCH][MAX_MOVES];
+    Game games[GAME_BATCH];
+    size_t counts[GAME_BATCH];
+    Move moves[MAX_MOVES];
+    Game_Batch b;
+    Card_Batch c;
+    uint16_t accepts[BATCH_PILES];
+    int8_t first[GAME_BATCH];
+    uint64_t rng = 0xC4EC;
+    size_t checked = 0, onto_foundation = 0, onto_empty = 0;
+    for (size_t round = 0; round < CHECK_ROUNDS; round++) {
+        batch_clear(&b);
+        size_t most = 0;
+        for (size_t lane = 0; lane < GAME_BATCH; lane++) {
+            Game *game = &games[lane];
+            *game = deals[(round*GAME_BATCH + lane) % BENCH_DEALS];
+            size_t played = rng_below(&rng, PLAYOUT_MAX_MOVES);
+            for (size_t m = 0; m < played; m++) {
+                size_t n = listMoves_draw1(game, moves);
+                if (n == 0) break;
+                size_t pick = rng_below(&rng, n);
+                if (rng_below(&rng, 2)) {
+                    for (size_t i = 0; i < n; i++) {
+                        if (moves[i].to.kind == PILE_FOUNDATION && moves[i].from.kind != PILE_FOUNDATION) pick = i;
+                    }
+                }
+                applyMove_draw1(game, moves[pick]);
+            }
+            batch_load(&b, lane, game);
+            counts[lane] = list_candidates(game, candidates[lane]);
+            if (counts[lane] > most) most = counts[lane];
+        }
+        for (size_t k = 0; k < most; k++) {
+            batch_clear_candidates(&c);
+            for (size_t lane = 0; lane < GAME_BATCH; lane++) {
+                if (k < counts[lane]) batch_set_candidate(&c, lane, candidates[lane][k]);
+            }
+            batch_accepts(&b, &c, accepts);
+            uint16_t found = batch_first_targets(accepts, first);
+            for (size_t lane = 0; lane < GAME_BATCH; lane++) {
+                Pile_Ref want = { PILE_RESERVE, 0 }, got = want; // reserve = no target
+                if (k < counts[lane]) findMoveTarget(&games[lane], candidates[lane][k], &want);
+                if (found & (1u << lane)) got = batch_pile_ref(first[lane]);
+                if (want.kind != got.kind || want.index != got.index) {
+                    Card card = candidates[lane][k].data[0];
+                    fprintf(stderr, "batch targets (%s) disagree with findMoveTarget in round %zu, lane %zu, candidate %zu "
+                            "(value %d, suit %d, %zu cards): want pile kind %d index %d, got kind %d index %d\n",
+                            batch_isa, round, lane, k, card.value, card.suit, candidates[lane][k].count,
+                            want.kind, want.index, got.kind, got.index);
+                    return false;
+                }
+                if (k >= counts[lane]) continue;
+                checked++;
+                if (want.kind == PILE_FOUNDATION && games[lane].foundation[want.index].count > 0) onto_foundation++;
+                if (want.kind == PILE_TABLEAU && games[lane].tableau[want.index].count == 0) onto_empty++;
+            }
+        }
+    }
+    printf("batch targets/%s match findMoveTarget on %zu candidates (%zu onto a started foundation, %zu kings onto an empty column)\n",
+           batch_isa, checked, onto_foundation, onto_empty);
+    return true;
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < BENCH_DEALS; i++) dealGame(&deals[i], i);
+    for (size_t i = 0; i < BENCH_DEALS; i++) {
+        if (i % GAME_BATCH == 0) batch_clear(&batches[i/GAME_BATCH]);
+        batch_load(&batches[i/GAME_BATCH], i % GAME_BATCH, &deals[i]);
+    }
+    if (!check_batch_targets()) return 1;
+
+    bench("pile_split", bench_pile_split, 1 << 22);
+    bench("pile_append_many", bench_pile_append_many, 1 << 22);
+    bench("findMoveTarget", bench_find_move_target, 1 << 22);
+    char batch_name[32];
+    snprintf(batch_name, sizeof batch_name, "batch targets/%s", batch_isa);
+    bench(batch_name, bench_batch_targets, 1 << 22);
+    bench("dealGame", bench_deal, 1 << 18);
+    size_t games = 1 << 10;
+    double ns = bench("random playout", bench_playout, games);
+    // counters are from the last repetition, which played the same games as every other
+    printf("%-20s %10.0f games/s, %.1f M moves/s, %.1f moves/game, %llu/%zu won, %llu/%zu hit the move cap\n",
+           "", 1e9/ns, playout_moves/(ns*games)*1e3, (double)playout_moves/games,
+           (unsigned long long)playout_wins, games, (unsigned long long)playout_capped, games);
+    return 0;
+}
@@ -0,0 +1,379 @@
+// board.h - rule-table driven engine for other solitaire games (FreeCell, Spider)
+//
+// solitaire.h is Klondike and only Klondike: fixed pile counts, one deck,
+// cards carrying their screen position. A Board is a flat array of piles of
+// one-byte cards, each pile a span of the board's card arena like the piles
+// of a Game, and a Board_Rules table says how many piles of each kind
+// there are and what each kind accepts. Move generation, move application and
+// dealing are written once against the table. Klondike's rules live in
+// solitaire.h alone, so there is no stock-to-waste drawing in here.
+//
+// This is the rules engine only. main.c draws and plays Klondike, and nothing
+// draws a Board yet; tools/sim.c is what plays these games.
+//
+// Like the Klondike variants in solitaire.h, every game in BOARD_VARIANTS gets
+// its own listBoardMoves_<name>()/applyBoardMove_<name>() that inline the
+// shared code with a pointer to that game's static const rules, so the
+// compiler folds the table away and the move loop doesn't look rules up.
+//
+// Define BOARD_IMPLEMENTATION in exactly one translation unit before including
+// this header. Include solitaire.h first (for the suits, faces and rng).
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#ifndef SOLITAIRE_H_
+#error "include solitaire.h before board.h"
+#endif
+
+// rank in the low nibble, suit in bits 4-5, face up in bit 7
+typedef uint8_t Board_Card;
+#define BCARD(rank, suit) ((Board_Card)((rank) | (suit) << 4))
+#define BCARD_RANK(c) ((c) & 0x0F)
+#define BCARD_SUIT(c) (((c) >> 4) & 0x03)
+#define BCARD_UP 0x80
+#define BCARD_IS_BLACK(c) (BCARD_SUIT(c) == SPADES || BCARD_SUIT(c) == CLUBS)
+
+#define BOARD_MAX_PILES 24
+#define BOARD_MAX_CARDS (2*52)
+#define BOARD_MAX_TABLEAU 10
+#define BOARD_MAX_MOVES 1024
+// the largest layout board_layout() makes, Spider's: ten columns of their
+// dealt cards plus six runs of 13, eight foundations of 13 and the stock
+#define BOARD_ARENA_CARDS 988
+
+typedef struct {
+    Board_Card cards[BOARD_ARENA_CARDS]; // every pile below is a span of this
+    Pile piles[BOARD_MAX_PILES];
+} Board;
+
+// what may be put on a non-empty tableau pile, or lifted off one as a unit
+typedef enum {
+    BUILD_ALT_COLOR,  // one lower, other color
+    BUILD_SAME_SUIT,  // one lower, same suit
+    BUILD_ANY_SUIT,   // one lower
+} Build_Rule;
+
+typedef enum {
+    STOCK_NONE,
+    STOCK_DEAL_ROW, // Spider: one card onto every tableau pile, none of them empty
+} Stock_Rule;
+
+typedef enum {
+    FOUNDATION_BY_SUIT,     // ace up to king, one card at a time
+    FOUNDATION_WHOLE_SUIT,  // Spider: a finished king-to-ace run goes up by itself
+} Foundation_Rule;
+
+typedef struct {
+    const char *name;
+    int decks;
+    int suits; // distinct suits in play, the decks are filled out by repeating them
+    int tableau;
+    int foundations;
+    int cells;
+    uint8_t deal_down[BOARD_MAX_TABLEAU]; // face-down cards dealt to each tableau pile
+    uint8_t deal_up[BOARD_MAX_TABLEAU];   // then face-up cards on top
+    Build_Rule build;  // onto the tableau
+    Build_Rule lift;   // runs that move together; FreeCell limits their length by free space
+    bool lift_limited;
+    Stock_Rule stock;
+    Foundation_Rule foundation;
+} Board_Rules;
+
+// any card may go on an empty tableau pile in every game here
+typedef enum {
+    BMOVE_RUN,     // the cards from `start` up in `from` go onto `to`
+    BMOVE_DEAL_ROW,
+} Board_Move_Kind;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t from;
+    uint8_t to;
+    uint8_t start;
+} Board_Move;
+
+// Pile layout: tableau, then foundations, then cells, then the stock.
+static inline int board_first_foundation(const Board_Rules *r) { return r->tableau; }
+static inline int board_first_cell(const Board_Rules *r) { return r->tableau + r->foundations; }
+static inline int board_stock(const Board_Rules *r) { return r->tableau + r->foundations + r->cells; }
+
+#define BOARD_VARIANTS(X) \
+    X(freecell) \
+    X(spider1)  \
+    X(spider2)  \
+    X(spider4)
+
+static const Board_Rules board_rules_freecell = {
+    .name = "freecell", .decks = 1, .suits = 4, .tableau = 8, .foundations = 4, .cells = 4,
+    .deal_up = { 7, 7, 7, 7, 6, 6, 6, 6 },
+    .build = BUILD_ALT_COLOR, .lift = BUILD_ALT_COLOR, .lift_limited = true,
+    .stock = STOCK_NONE,
+    .foundation = FOUNDATION_BY_SUIT,
+};
+
+#define BOARD_SPIDER_RULES(n, suit_count) \
+    static const Board_Rules board_rules_spider##n = { \
+        .name = "spider" #n, .decks = 2, .suits = suit_count, .tableau = 10, .foundations = 8, .cells = 0, \
+        .deal_down = { 5, 5, 5, 5, 4, 4, 4, 4, 4, 4 }, .deal_up = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, \
+        .build = BUILD_ANY_SUIT, .lift = BUILD_SAME_SUIT, \
+        .stock = STOCK_DEAL_ROW, \
+        .foundation = FOUNDATION_WHOLE_SUIT, \
+    };
+BOARD_SPIDER_RULES(1, 1)
+BOARD_SPIDER_RULES(2, 2)
+BOARD_SPIDER_RULES(4, 4)
+
+void dealBoard(Board *board, const Board_Rules *rules, uint64_t seed);
+static inline const Board_Card *board_pile_cards(const Board *board, int pile)
+{
+    return board->cards + board->piles[pile].offset;
+}
+bool isBoardWon(const Board *board, const Board_Rules *rules);
+
+#define BOARD_DECLARE_VARIANT(name) \
+    size_t listBoardMoves_##name(Board *board, Board_Move *moves); \
+    void applyBoardMove_##name(Board *board, Board_Move move);
+BOARD_VARIANTS(BOARD_DECLARE_VARIANT)
+
+#endif // BOARD_H_
+
+#ifdef BOARD_IMPLEMENTATION
+
+#include <assert.h>
+#include <string.h>
+
+static const enum suit board_suit_order[SUIT_COUNT] = { SPADES, HEARTS, CLUBS, DIAMONDS };
+
+static inline Board_Card board_top(const Board *board, const Pile *p)
+{
+    return board->cards[p->offset + p->count-1];
+}
+
+static inline void board_push(Board *board, Pile *p, Board_Card c)
+{
+    assert(p->count < p->cap);
+    board->cards[p->offset + p->count++] = c;
+}
+
+static inline bool board_builds(Build_Rule rule, Board_Card lower, Board_Card upper)
+{
+    if (BCARD_RANK(lower) + 1 != BCARD_RANK(upper)) return false;
+    switch (rule) {
+    case BUILD_ALT_COLOR: return BCARD_IS_BLACK(lower) != BCARD_IS_BLACK(upper);
+    case BUILD_SAME_SUIT: return BCARD_SUIT(lower) == BCARD_SUIT(upper);
+    case BUILD_ANY_SUIT:  return true;
+    }
+    return false;
+}
+
+// Gives every pile its span of the arena. A tableau pile holds its dealt cards
+// and on top of those descending runs of at most 13, one for what is built on
+// the deal and one more for each row the stock deals onto it.
+static void board_layout(Board *board, const Board_Rules *rules)
+{
+    int dealt = 0;
+    for (int i = 0; i < rules->tableau; i++) dealt += rules->deal_down[i] + rules->deal_up[i];
+    int stock = rules->stock == STOCK_NONE ? 0 : 52*rules->decks - dealt;
+    int rows = rules->stock == STOCK_DEAL_ROW ? stock/rules->tableau : 0;
+    uint16_t offset = 0;
+    for (int i = 0; i < board_stock(rules) + 1; i++) {
+        uint16_t cap;
+        if (i < rules->tableau) cap = rules->deal_down[i] + rules->deal_up[i] + 13*(rows+1);
+        else if (i < board_first_cell(rules)) cap = 13;
+        else if (i < board_stock(rules)) cap = 1;
+        else cap = stock;
+        board->piles[i] = (Pile) { offset, 0, cap };
+        offset += cap;
+    }
+    assert(offset <= BOARD_ARENA_CARDS);
+}
+
+void dealBoard(Board *board, const Board_Rules *rules, uint64_t seed)
+{
+    uint64_t rng = seed;
+    board_layout(board, rules);
+    Board_Card deck[BOARD_MAX_CARDS];
+    int n = 0;
+    for (int d = 0; d < rules->decks; d++) {
+        for (int s = 0; s < SUIT_COUNT; s++) {
+            for (int rank = FACE_ACE; rank <= FACE_KING; rank++) {
+                deck[n++] = BCARD(rank, board_suit_order[s % rules->suits]);
+            }
+        }
+    }
+    for (int i = n-1; i > 0; i--) {
+        int r = rng_below(&rng, i+1);
+        Board_Card tmp = deck[r];
+        deck[r] = deck[i];
+        deck[i] = tmp;
+    }
+    for (int i = 0; i < rules->tableau; i++) {
+        Pile *p = &board->piles[i];
+        for (int j = 0; j < rules->deal_down[i]; j++) board_push(board, p, deck[--n]);
+        for (int j = 0; j < rules->deal_up[i]; j++) board_push(board, p, deck[--n] | BCARD_UP);
+    }
+    if (rules->stock != STOCK_NONE) {
+        while (n > 0) board_push(board, &board->piles[board_stock(rules)], deck[--n]);
+    }
+    assert(n == 0);
+}
+
+bool isBoardWon(const Board *board, const Board_Rules *rules)
+{
+    int total = 0;
+    for (int i = 0; i < rules->foundations; i++) total += board->piles[board_first_foundation(rules) + i].count;
+    return total == 52*rules->decks;
+}
+
+// FreeCell moves a long run one card at a time through free cells and empty
+// columns, which is the same as allowing (cells+1) * 2^columns cards at once
+static inline int board_max_lift(const Board *board, const Board_Rules *rules, bool to_empty)
+{
+    if (!rules->lift_limited) return BOARD_MAX_CARDS;
+    int cells = 0, columns = 0;
+    for (int i = 0; i < rules->cells; i++) cells += board->piles[board_first_cell(rules) + i].count == 0;
+    for (int i = 0; i < rules->tableau; i++) columns += board->piles[i].count == 0;
+    if (to_empty && columns > 0) columns--; // the one moved into doesn't count; with none, nothing moves into one
+    return (cells + 1) << columns;
+}
+
+static inline __attribute__((always_inline))
+size_t listBoardMovesWith(Board *board, Board_Move *moves, const Board_Rules *rules)
+{
+    size_t n = 0;
+#define BOARD_ADD_MOVE(...) do { if (n < BOARD_MAX_MOVES) moves[n++] = (Board_Move) { __VA_ARGS__ }; } while (0)
+    // which piles take which card, built once so each candidate is a lookup
+    // instead of a scan over every pile
+    uint16_t to_tableau[FACE_COUNT][SUIT_COUNT] = {0}; // mask of non-empty tableau piles
+    int8_t to_foundation[FACE_COUNT][SUIT_COUNT];      // first foundation, -1 if none
+    memset(to_foundation, -1, sizeof(to_foundation));
+    int first_empty = -1;
+    for (int i = rules->tableau-1; i >= 0; i--) {
+        const Pile *p = &board->piles[i];
+        if (p->count == 0) {
+            first_empty = i;
+            continue;
+        }
+        Board_Card top = board_top(board, p);
+        if (BCARD_RANK(top) == FACE_ACE) continue;
+        for (int s = 0; s < SUIT_COUNT; s++) {
+            if (board_builds(rules->build, BCARD(BCARD_RANK(top)-1, s), top)) to_tableau[BCARD_RANK(top)-1][s] |= 1 << i;
+        }
+    }
+    if (rules->foundation == FOUNDATION_BY_SUIT) {
+        for (int f = rules->foundations-1; f >= 0; f--) {
+            int dst = board_first_foundation(rules) + f;
+            const Pile *fp = &board->piles[dst];
+            if (fp->count == 0) {
+                for (int s = 0; s < SUIT_COUNT; s++) to_foundation[FACE_ACE][s] = dst;
+            } else if (BCARD_RANK(board_top(board, fp)) < FACE_KING) {
+                Board_Card top = board_top(board, fp);
+                to_foundation[BCARD_RANK(top)+1][BCARD_SUIT(top)] = dst;
+            }
+        }
+    }
+    int first_free_cell = -1;
+    for (int i = 0; i < rules->cells; i++) {
+        if (board->piles[board_first_cell(rules) + i].count == 0) {
+            first_free_cell = board_first_cell(rules) + i;
+            break;
+        }
+    }
+    int max_lift = board_max_lift(board, rules, false);
+    int max_lift_empty = board_max_lift(board, rules, true);
+
+    // single cards that could also go to a foundation or cell: tableau tops and cell cards
+    for (int src = 0; src < board_stock(rules); src++) {
+        bool tableau = src < rules->tableau;
+        if (!tableau && src < board_first_cell(rules)) continue;
+        const Pile *p = &board->piles[src];
+        if (p->count == 0) continue;
+        const Board_Card *cards = board->cards + p->offset;
+        Board_Card top = cards[p->count-1];
+
+        int f = to_foundation[BCARD_RANK(top)][BCARD_SUIT(top)];
+        if (f >= 0) BOARD_ADD_MOVE(BMOVE_RUN, src, f, p->count-1);
+        if (tableau && first_free_cell >= 0) BOARD_ADD_MOVE(BMOVE_RUN, src, first_free_cell, p->count-1);
+
+        // runs onto other tableau piles; from a tableau pile every valid run
+        // counts, from a cell only its card
+        int lowest = p->count-1;
+        if (tableau) {
+            while (lowest > 0 && (cards[lowest-1] & BCARD_UP) && board_builds(rules->lift, cards[lowest], cards[lowest-1])) lowest--;
+        }
+        for (int start = p->count-1; start >= lowest; start--) {
+            Board_Card c = cards[start];
+            int len = p->count - start;
+            uint16_t mask = len <= max_lift ? to_tableau[BCARD_RANK(c)][BCARD_SUIT(c)] & ~(1u << src) : 0;
+            while (mask) {
+                BOARD_ADD_MOVE(BMOVE_RUN, src, __builtin_ctz(mask), start);
+                mask &= mask - 1;
+            }
+            // one empty column is as good as another, and moving a whole pile into one changes nothing
+            if (first_empty >= 0 && !(tableau && start == 0) && len <= max_lift_empty) {
+                BOARD_ADD_MOVE(BMOVE_RUN, src, first_empty, start);
+            }
+        }
+    }
+
+    int stock = board_stock(rules);
+    if (rules->stock == STOCK_DEAL_ROW && board->piles[stock].count >= rules->tableau && first_empty < 0) {
+        BOARD_ADD_MOVE(BMOVE_DEAL_ROW, stock, 0, 0);
+    }
+#undef BOARD_ADD_MOVE
+    return n;
+}
+
+// Spider: a king-to-ace run of one suit on top of a tableau pile goes up by itself
+static inline void board_collect_suit(Board *board, const Board_Rules *rules, int pile)
+{
+    Pile *p = &board->piles[pile];
+    if (p->count < 13) return;
+    Board_Card *cards = board->cards + p->offset;
+    int start = p->count - 13;
+    if (BCARD_RANK(cards[start]) != FACE_KING) return;
+    for (int i = start; i < p->count - 1; i++) {
+        if (!(cards[i] & BCARD_UP) || !board_builds(BUILD_SAME_SUIT, cards[i+1], cards[i])) return;
+    }
+    for (int f = 0; f < rules->foundations; f++) {
+        Pile *fp = &board->piles[board_first_foundation(rules) + f];
+        if (fp->count > 0) continue;
+        memcpy(board->cards + fp->offset, cards + start, 13);
+        fp->count = 13;
+        p->count = start;
+        if (p->count > 0) cards[p->count-1] |= BCARD_UP;
+        return;
+    }
+}
+
+static inline __attribute__((always_inline))
+void applyBoardMoveWith(Board *board, Board_Move move, const Board_Rules *rules)
+{
+    Pile *from = &board->piles[move.from];
+    Pile *to = &board->piles[move.to];
+    switch (move.kind) {
+    case BMOVE_RUN: {
+        int len = from->count - move.start;
+        assert(to->count + len <= to->cap);
+        memcpy(board->cards + to->offset + to->count, board->cards + from->offset + move.start, len);
+        to->count += len;
+        from->count = move.start;
+        if (move.from < rules->tableau && from->count > 0) board->cards[from->offset + from->count-1] |= BCARD_UP;
+        if (rules->foundation == FOUNDATION_WHOLE_SUIT && move.to < rules->tableau) board_collect_suit(board, rules, move.to);
+    } break;
+    case BMOVE_DEAL_ROW:
+        for (int i = 0; i < rules->tableau; i++) {
+            from->count--;
+            board_push(board, &board->piles[i], board->cards[from->offset + from->count] | BCARD_UP);
+            if (rules->foundation == FOUNDATION_WHOLE_SUIT) board_collect_suit(board, rules, i);
+        }
+        break;
+    }
+}
+
+#define BOARD_DEFINE_VARIANT(name) \
+    size_t listBoardMoves_##name(Board *board, Board_Move *moves) { return listBoardMovesWith(board, moves, &board_rules_##name); } \
+    void applyBoardMove_##name(Board *board, Board_Move move) { applyBoardMoveWith(board, move, &board_rules_##name); }
+BOARD_VARIANTS(BOARD_DEFINE_VARIANT)
+
+#endif // BOARD_IMPLEMENTATION
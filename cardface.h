@@ -0,0 +1,276 @@
+// cardface.h - card faces drawn from signed distance fields instead of bitmaps
+//
+// The card PNGs are 500x726 each, 54 of them, and get scaled down to a card
+// that's about 150 pixels wide on a phone. A face needs far less than that:
+// a rank, a suit pip, and a rounded rectangle to put them on. This header
+// keeps one small signed distance field per glyph (13 ranks, 4 suits) and
+// turns any of them into an antialiased coverage mask at whatever pixel size
+// the cards end up at, so they're exactly as sharp at every card_scale.
+//
+// The fields are built at startup from stroke outlines (ranks) and closed
+// form shapes (suits), there is no atlas file to ship. Resolving to coverage
+// happens on the CPU rather than in a fragment shader because rlsw, which
+// the host benchmark renders with, has no shaders; the result is a plain
+// alpha mask any renderer can draw and tint. The card's rounded rectangle
+// is resolved the same way, from its exact distance function.
+//
+// Define CARDFACE_IMPLEMENTATION in exactly one translation unit before
+// including this header. Include solitaire.h first (for the suits and faces).
+#ifndef CARDFACE_H_
+#define CARDFACE_H_
+
+#ifndef SOLITAIRE_H_
+#error "include solitaire.h before cardface.h"
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CARDFACE_CELL 48        // field texels across a glyph cell
+#define CARDFACE_SPREAD 6.0f    // field texels of distance either side of an edge a byte can hold
+#define CARDFACE_UNITS 14.0f    // glyph units across a cell
+#define CARDFACE_INK 10.0f      // glyph units a rank or suit is tall, centered in the cell
+#define CARDFACE_GLYPH_COUNT (FACE_KING + SUIT_COUNT)
+
+typedef struct {
+    // 128 on the edge, higher inside
+    uint8_t field[CARDFACE_GLYPH_COUNT][CARDFACE_CELL*CARDFACE_CELL];
+} Cardface_Atlas;
+
+static inline int cardface_rank(int value) { return value - FACE_ACE; }
+static inline int cardface_suit(enum suit suit) { return FACE_KING + suit; }
+
+void cardface_build(Cardface_Atlas *atlas);
+// writes glyph coverage, 0-255, for a `size`x`size` pixel cell; pixel (x, y)
+// goes to out[y*pitch + x*step], so an RGBA image's alpha can be filled in place
+void cardface_resolve(const Cardface_Atlas *atlas, int glyph, int size, uint8_t *out, size_t pitch, size_t step);
+// coverage of a `width`x`height` pixel rectangle with corners of `radius`,
+// shrunk by `inset` on every side, written the same way; from its exact
+// distance, no field needed
+void cardface_resolve_box(int width, int height, float radius, float inset, uint8_t *out, size_t pitch, size_t step);
+
+#endif // CARDFACE_H_
+
+#ifdef CARDFACE_IMPLEMENTATION
+
+#include <math.h>
+
+#define CARDFACE_STROKE 0.8f // half the width of a rank's strokes, glyph units
+
+typedef enum {
+    CARDFACE_END,
+    CARDFACE_LINE, // x0 y0 x1 y1
+    CARDFACE_ARC,  // cx cy r from to, degrees clockwise from +x with y down; to > from
+} Cardface_Stroke_Kind;
+
+typedef struct {
+    Cardface_Stroke_Kind kind;
+    float a, b, c, d, e;
+} Cardface_Stroke;
+
+// ranks are drawn in a box `width` units wide and 10 tall, y down
+typedef struct {
+    float width;
+    Cardface_Stroke strokes[8];
+} Cardface_Rank;
+
+#define L(x0, y0, x1, y1) { CARDFACE_LINE, x0, y0, x1, y1, 0 }
+#define A(cx, cy, r, from, to) { CARDFACE_ARC, cx, cy, r, from, to }
+static const Cardface_Rank cardface_ranks[FACE_KING] = {
+    [0]  = { 6, { L(0, 10, 3, 0), L(3, 0, 6, 10), L(1.2f, 6.5f, 4.8f, 6.5f) } },
+    [1]  = { 6, { A(3, 3, 3, 180, 390), L(5.6f, 4.5f, 0, 10), L(0, 10, 6, 10) } },
+    [2]  = { 6, { A(3, 2.6f, 2.6f, 200, 450), A(3, 7.2f, 2.8f, 270, 520) } },
+    [3]  = { 6, { L(4.5f, 10, 4.5f, 0), L(4.5f, 0, 0, 7), L(0, 7, 6, 7) } },
+    [4]  = { 6, { L(5.5f, 0, 1.2f, 0), L(1.2f, 0, 1.2f, 4.2f), A(3, 6.8f, 3.2f, 235, 520) } },
+    [5]  = { 6, { A(3, 7, 3, 0, 360), A(7, 7, 7, 180, 245) } },
+    [6]  = { 6, { L(0, 0, 6, 0), L(6, 0, 2, 10) } },
+    [7]  = { 6, { A(3, 2.5f, 2.5f, 0, 360), A(3, 7.2f, 2.8f, 0, 360) } },
+    [8]  = { 6, { A(3, 3, 3, 0, 360), A(-1, 3, 7, 0, 65) } },
+    [9]  = { 8.6f, { L(0, 1.5f, 1.5f, 0), L(1.5f, 0, 1.5f, 10),
+                     A(6.1f, 2.5f, 2.5f, 180, 360), L(3.6f, 2.5f, 3.6f, 7.5f), L(8.6f, 2.5f, 8.6f, 7.5f), A(6.1f, 7.5f, 2.5f, 0, 180) } },
+    [10] = { 6, { L(2.5f, 0, 6, 0), L(6, 0, 6, 7), A(3, 7, 3, 0, 160) } },
+    [11] = { 6, { A(3, 3, 3, 180, 360), L(0, 3, 0, 7), L(6, 3, 6, 7), A(3, 7, 3, 0, 180), L(3.5f, 6.5f, 6.5f, 10) } },
+    [12] = { 6, { L(0, 0, 0, 10), L(6, 0, 0, 6), L(2, 4.3f, 6, 10) } },
+};
+#undef L
+#undef A
+
+static float cardface_segment(float px, float py, float x0, float y0, float x1, float y1)
+{
+    float dx = x1 - x0, dy = y1 - y0;
+    float t = ((px - x0)*dx + (py - y0)*dy) / (dx*dx + dy*dy);
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    return hypotf(px - (x0 + t*dx), py - (y0 + t*dy));
+}
+
+static float cardface_arc(float px, float py, const Cardface_Stroke *s)
+{
+    float dx = px - s->a, dy = py - s->b;
+    if (s->e - s->d < 360) {
+        float t = atan2f(dy, dx)*(180.0f/(float)M_PI);
+        if (t < 0) t += 360;
+        if (t < s->d) t += 360;
+        if (t > s->e) {
+            // past either end, nearest end point
+            float r0 = s->d*((float)M_PI/180), r1 = s->e*((float)M_PI/180);
+            return fminf(hypotf(px - (s->a + s->c*cosf(r0)), py - (s->b + s->c*sinf(r0))),
+                         hypotf(px - (s->a + s->c*cosf(r1)), py - (s->b + s->c*sinf(r1))));
+        }
+    }
+    return fabsf(hypotf(dx, dy) - s->c);
+}
+
+static float cardface_rank_distance(const Cardface_Rank *rank, float px, float py)
+{
+    float d = INFINITY;
+    for (const Cardface_Stroke *s = rank->strokes; s->kind != CARDFACE_END; s++) {
+        float ds = s->kind == CARDFACE_LINE ? cardface_segment(px, py, s->a, s->b, s->c, s->d) : cardface_arc(px, py, s);
+        if (ds < d) d = ds;
+    }
+    return d - CARDFACE_STROKE;
+}
+
+// the shapes below are in a square from -1 to 1, y down, and return
+// distances in those units; negative inside
+
+static float cardface_heart_up(float x, float y)
+{
+    // tip at the origin, lobes up to y ~1.1; see iquilezles.org/articles/distfunctions2d
+    x = fabsf(x);
+    if (x + y > 1) return hypotf(x - 0.25f, y - 0.75f) - sqrtf(2)/4;
+    float h = fmaxf(x + y, 0)*0.5f;
+    float d = fminf(hypotf(x, y - 1), hypotf(x - h, y - h));
+    return x > y ? d : -d;
+}
+
+static float cardface_triangle(float x, float y, const float v[6])
+{
+    float d = INFINITY;
+    bool inside = true;
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        d = fminf(d, cardface_segment(x, y, v[2*i], v[2*i + 1], v[2*j], v[2*j + 1]));
+        // clockwise in y-down coordinates
+        float cross = (v[2*j] - v[2*i])*(y - v[2*i + 1]) - (v[2*j + 1] - v[2*i + 1])*(x - v[2*i]);
+        if (cross < 0) inside = false;
+    }
+    return inside ? -d : d;
+}
+
+static const float cardface_stem[6] = { 0, 0.1f, 0.38f, 1, -0.38f, 1 };
+
+static float cardface_suit_distance(enum suit suit, float x, float y)
+{
+    switch (suit) {
+    case HEARTS: {
+        const float k = 0.55f;
+        return cardface_heart_up(x*k, (1 - y)*k)/k;
+    }
+    case SPADES: {
+        const float k = 0.7f;
+        float blade = cardface_heart_up(x*k, (y + 1)*k)/k;
+        return fminf(blade, cardface_triangle(x, y, cardface_stem));
+    }
+    case CLUBS: {
+        float d = hypotf(x, y + 0.52f) - 0.44f;
+        d = fminf(d, hypotf(x + 0.5f, y - 0.12f) - 0.44f);
+        d = fminf(d, hypotf(x - 0.5f, y - 0.12f) - 0.44f);
+        d = fminf(d, hypotf(x, y - 0.05f) - 0.25f);
+        return fminf(d, cardface_triangle(x, y, cardface_stem));
+    }
+    case DIAMONDS: {
+        // rhombus with half-diagonals bx, by
+        const float bx = 0.75f, by = 1.0f;
+        x = fabsf(x);
+        y = fabsf(y);
+        float h = ((bx - 2*x)*bx - (by - 2*y)*by) / (bx*bx + by*by);
+        if (h < -1) h = -1;
+        if (h > 1) h = 1;
+        float d = hypotf(x - 0.5f*bx*(1 - h), y - 0.5f*by*(1 + h));
+        return x*by + y*bx - bx*by < 0 ? -d : d;
+    }
+    default:
+        return INFINITY;
+    }
+}
+
+void cardface_build(Cardface_Atlas *atlas)
+{
+    const float units_per_texel = CARDFACE_UNITS/CARDFACE_CELL;
+    const float margin = 0.5f*(CARDFACE_UNITS - CARDFACE_INK);
+    for (int g = 0; g < CARDFACE_GLYPH_COUNT; g++) {
+        for (int ty = 0; ty < CARDFACE_CELL; ty++) {
+            for (int tx = 0; tx < CARDFACE_CELL; tx++) {
+                // glyph units, the 10x10 ink box starting at the origin
+                float x = (tx + 0.5f)*units_per_texel - margin;
+                float y = (ty + 0.5f)*units_per_texel - margin;
+                float d;
+                if (g < FACE_KING) {
+                    const Cardface_Rank *rank = &cardface_ranks[g];
+                    d = cardface_rank_distance(rank, x - 0.5f*(CARDFACE_INK - rank->width), y);
+                } else {
+                    float half = 0.5f*CARDFACE_INK;
+                    d = cardface_suit_distance((enum suit)(g - FACE_KING), (x - half)/half, (y - half)/half)*half;
+                }
+                float v = 128 - d/units_per_texel*(127/CARDFACE_SPREAD);
+                if (v < 0) v = 0;
+                if (v > 255) v = 255;
+                atlas->field[g][ty*CARDFACE_CELL + tx] = (uint8_t)(v + 0.5f);
+            }
+        }
+    }
+}
+
+static float cardface_sample(const uint8_t *field, float u, float v)
+{
+    if (u < 0) u = 0;
+    if (v < 0) v = 0;
+    if (u > CARDFACE_CELL - 1) u = CARDFACE_CELL - 1;
+    if (v > CARDFACE_CELL - 1) v = CARDFACE_CELL - 1;
+    int x0 = (int)u, y0 = (int)v;
+    int x1 = x0 + 1 < CARDFACE_CELL ? x0 + 1 : x0;
+    int y1 = y0 + 1 < CARDFACE_CELL ? y0 + 1 : y0;
+    float fx = u - x0, fy = v - y0;
+    float top = field[y0*CARDFACE_CELL + x0]*(1 - fx) + field[y0*CARDFACE_CELL + x1]*fx;
+    float bottom = field[y1*CARDFACE_CELL + x0]*(1 - fx) + field[y1*CARDFACE_CELL + x1]*fx;
+    return top*(1 - fy) + bottom*fy;
+}
+
+void cardface_resolve(const Cardface_Atlas *atlas, int glyph, int size, uint8_t *out, size_t pitch, size_t step)
+{
+    const uint8_t *field = atlas->field[glyph];
+    float texels_per_pixel = (float)CARDFACE_CELL/size;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            float f = cardface_sample(field, (x + 0.5f)*texels_per_pixel - 0.5f, (y + 0.5f)*texels_per_pixel - 0.5f);
+            // signed distance in output pixels, positive outside
+            float d = (128 - f)*(CARDFACE_SPREAD/127)/texels_per_pixel;
+            float coverage = 0.5f - d;
+            if (coverage < 0) coverage = 0;
+            if (coverage > 1) coverage = 1;
+            out[y*pitch + x*step] = (uint8_t)(coverage*255 + 0.5f);
+        }
+    }
+}
+
+void cardface_resolve_box(int width, int height, float radius, float inset, uint8_t *out, size_t pitch, size_t step)
+{
+    float hx = 0.5f*width - inset, hy = 0.5f*height - inset;
+    if (radius > hx) radius = hx;
+    if (radius > hy) radius = hy;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float qx = fabsf(x + 0.5f - 0.5f*width) - (hx - radius);
+            float qy = fabsf(y + 0.5f - 0.5f*height) - (hy - radius);
+            float d = hypotf(fmaxf(qx, 0), fmaxf(qy, 0)) + fminf(fmaxf(qx, qy), 0) - radius;
+            float coverage = 0.5f - d;
+            if (coverage < 0) coverage = 0;
+            if (coverage > 1) coverage = 1;
+            out[y*pitch + x*step] = (uint8_t)(coverage*255 + 0.5f);
+        }
+    }
+}
+
+#endif // CARDFACE_IMPLEMENTATION
@@ -421,6 +421,24 @@ typedef struct rlRenderBatch {
     float currentDepth;         // Current depth value for next draw
 } rlRenderBatch;
 
+// Render batch flush reasons
+typedef enum {
+    RL_FLUSH_EXPLICIT = 0,      // rlDrawRenderBatchActive(), EndDrawing(), mode/shader/framebuffer changes
+    RL_FLUSH_DRAWCALL_LIMIT,    // RL_DEFAULT_BATCH_DRAWCALLS draw calls accumulated
+    RL_FLUSH_BUFFER_OVERFLOW,   // Vertex buffer full
+    RL_FLUSH_REASON_COUNT
+} rlFlushReason;
+
+// Render batch statistics, accumulated until rlResetBatchStats()
+// NOTE: On OpenGL 1.1 (and software renderer) every rlBegin()/rlEnd() pair is counted as a draw call
+// and there are no batch flushes
+typedef struct rlBatchStats {
+    int drawCalls;              // Draw calls submitted to the GPU
+    int vertices;               // Vertices submitted (excluding alignment padding)
+    int textureSwitches;        // Texture changes that started a new draw call
+    int flushes[RL_FLUSH_REASON_COUNT]; // Non-empty batch flushes, by reason
+} rlBatchStats;
+
 // OpenGL version
 typedef enum {
     RL_OPENGL_SOFTWARE = 0,  // Software rendering
@@ -729,6 +747,8 @@ RLAPI void rlDrawRenderBatchActive(void);               // Update and draw inter
 RLAPI bool rlCheckRenderBatchLimit(int vCount);         // Check internal buffer overflow for a given number of vertex
 
 RLAPI void rlSetTexture(unsigned int id);               // Set current texture for render batch and check buffers limits
+RLAPI rlBatchStats rlGetBatchStats(void);               // Get render batch statistics accumulated since last reset
+RLAPI void rlResetBatchStats(void);                     // Reset render batch statistics (i.e. once per frame)
 
 //------------------------------------------------------------------------------------------------------------------------
 
@@ -1147,6 +1167,12 @@ static double rlCullDistanceFar = RL_CULL_DISTANCE_FAR;
 static rlglData RLGL = { 0 };
 #endif
 
+static rlBatchStats rlStats = { 0 };
+static rlFlushReason rlNextFlushReason = RL_FLUSH_EXPLICIT;   // Reason recorded by the next rlDrawRenderBatch()
+#if defined(GRAPHICS_API_OPENGL_11)
+static unsigned int rlLastTextureId = 0;                        // Texture enabled by rlSetTexture(), 0 while texturing is off
+#endif
+
 #if defined(GRAPHICS_API_OPENGL_ES2) && !defined(GRAPHICS_API_OPENGL_ES3)
 // VAO functions entry points
 // NOTE: VAO functionality is exposed through extensions (OES)
@@ -1453,6 +1479,7 @@ double rlGetCullDistanceFar(void)
 //---------------------------------------
 void rlBegin(int mode)
 {
+    rlStats.drawCalls++;
     switch (mode)
     {
         case RL_LINES: glBegin(GL_LINES); break;
@@ -1463,9 +1490,9 @@ void rlBegin(int mode)
 }
 
 void rlEnd(void) { glEnd(); }
-void rlVertex2i(int x, int y) { glVertex2i(x, y); }
-void rlVertex2f(float x, float y) { glVertex2f(x, y); }
-void rlVertex3f(float x, float y, float z) { glVertex3f(x, y, z); }
+void rlVertex2i(int x, int y) { rlStats.vertices++; glVertex2i(x, y); }
+void rlVertex2f(float x, float y) { rlStats.vertices++; glVertex2f(x, y); }
+void rlVertex3f(float x, float y, float z) { rlStats.vertices++; glVertex3f(x, y, z); }
 void rlTexCoord2f(float x, float y) { glTexCoord2f(x, y); }
 void rlNormal3f(float x, float y, float z) { glNormal3f(x, y, z); }
 void rlColor4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a) { glColor4ub(r, g, b, a); }
@@ -1498,7 +1525,11 @@ void rlBegin(int mode)
             }
         }
 
-        if (RLGL.currentBatch->drawCounter >= RL_DEFAULT_BATCH_DRAWCALLS) rlDrawRenderBatch(RLGL.currentBatch);
+        if (RLGL.currentBatch->drawCounter >= RL_DEFAULT_BATCH_DRAWCALLS)
+        {
+            rlNextFlushReason = RL_FLUSH_DRAWCALL_LIMIT;
+            rlDrawRenderBatch(RLGL.currentBatch);
+        }
 
         RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].mode = mode;
         RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].textureId = RLGL.State.currentTextureId;
@@ -1671,6 +1702,7 @@ void rlSetTexture(unsigned int id)
         if (RLGL.State.vertexCounter >=
             RLGL.currentBatch->vertexBuffer[RLGL.currentBatch->currentBuffer].elementCount*4)
         {
+            rlNextFlushReason = RL_FLUSH_BUFFER_OVERFLOW;
             rlDrawRenderBatch(RLGL.currentBatch);
         }
         RLGL.State.currentTextureId = RLGL.State.defaultTextureId;
@@ -1679,11 +1711,15 @@ void rlSetTexture(unsigned int id)
     else
     {
 #if defined(GRAPHICS_API_OPENGL_11)
+        if (id != rlLastTextureId) rlStats.textureSwitches++;
+        rlLastTextureId = id;
         rlEnableTexture(id);
 #else
         RLGL.State.currentTextureId = id;
         if (RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].textureId != id)
         {
+            rlStats.textureSwitches++;
+
             if (RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].vertexCount > 0)
             {
                 // Make sure current RLGL.currentBatch->draws[i].vertexCount is aligned a multiple of 4,
@@ -1706,7 +1742,11 @@ void rlSetTexture(unsigned int id)
                 }
             }
 
-            if (RLGL.currentBatch->drawCounter >= RL_DEFAULT_BATCH_DRAWCALLS) rlDrawRenderBatch(RLGL.currentBatch);
+            if (RLGL.currentBatch->drawCounter >= RL_DEFAULT_BATCH_DRAWCALLS)
+            {
+                rlNextFlushReason = RL_FLUSH_DRAWCALL_LIMIT;
+                rlDrawRenderBatch(RLGL.currentBatch);
+            }
 
             RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].textureId = id;
             RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].vertexCount = 0;
@@ -1737,6 +1777,7 @@ void rlDisableTexture(void)
 {
 #if defined(GRAPHICS_API_OPENGL_11)
     glDisable(GL_TEXTURE_2D);
+    rlLastTextureId = 0;    // Enabling any texture again is a switch
 #endif
     glBindTexture(GL_TEXTURE_2D, 0);
 }
@@ -2983,6 +3024,22 @@ void rlUnloadRenderBatch(rlRenderBatch batch)
 void rlDrawRenderBatch(rlRenderBatch *batch)
 {
 #if defined(GRAPHICS_API_OPENGL_33) || defined(GRAPHICS_API_OPENGL_ES2)
+    // Register batch statistics
+    if (RLGL.State.vertexCounter > 0)
+    {
+        int eyes = RLGL.State.stereoRender? 2 : 1;
+        rlStats.flushes[rlNextFlushReason]++;
+        for (int i = 0; i < batch->drawCounter; i++)
+        {
+            if (batch->draws[i].vertexCount > 0)
+            {
+                rlStats.drawCalls += eyes;
+                rlStats.vertices += eyes*batch->draws[i].vertexCount;
+            }
+        }
+    }
+    rlNextFlushReason = RL_FLUSH_EXPLICIT;
+
     // Update batch vertex buffers
     //------------------------------------------------------------------------------------------------------------
     // NOTE: If there is not vertex data, buffers doesn't need to be updated (vertexCount > 0)
@@ -3224,6 +3281,18 @@ void rlDrawRenderBatchActive(void)
 #endif
 }
 
+// Get render batch statistics accumulated since last reset
+rlBatchStats rlGetBatchStats(void)
+{
+    return rlStats;
+}
+
+// Reset render batch statistics
+void rlResetBatchStats(void)
+{
+    rlStats = (rlBatchStats){ 0 };
+}
+
 // Check internal buffer overflow for a given number of vertex
 // and force a rlRenderBatch draw call if required
 bool rlCheckRenderBatchLimit(int vCount)
@@ -3240,6 +3309,7 @@ bool rlCheckRenderBatchLimit(int vCount)
         int currentMode = RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].mode;
         int currentTexture = RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].textureId;
 
+        rlNextFlushReason = RL_FLUSH_BUFFER_OVERFLOW;
         rlDrawRenderBatch(RLGL.currentBatch);    // NOTE: Stereo rendering is checked inside
 
         // Restore state of last batch so new vertices can be added
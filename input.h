@@ -0,0 +1,199 @@
+// input.h - touch samples straight from the platform's input callback
+//
+// raylib folds touch input into one position per frame. Android hands over
+// more than that: every motion event carries the samples the touchscreen
+// batched since the previous one, each with its own timestamp. A Touch_Track
+// keeps the most recent of those, so a dragged card can be drawn where the
+// finger is now rather than where it was when the frame started, and
+// touch_predict() extrapolates a little further along the finger's recent
+// velocity to cover the time until the frame reaches the screen.
+//
+// A Touch_Queue carries the changes themselves (down, move, up) in the
+// order they happened, for the game to drain once per frame. Polling
+// raylib's per-frame state instead loses a tap that goes down and up between
+// two frames; the queue still has both. Moves are coalesced, only the latest
+// one is queued, since the Touch_Track has the full path.
+//
+// Timestamps are CLOCK_MONOTONIC nanoseconds, the clock Android stamps motion
+// events with; input_now_ns() reads the same clock.
+//
+// Define INPUT_IMPLEMENTATION in exactly one translation unit before
+// including this header.
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TOUCH_HISTORY 16 // samples kept, must be a power of two
+#define TOUCH_VELOCITY_WINDOW_NS 50000000ull // velocity is measured over this much history
+#define TOUCH_PREDICT_MAX_NS 20000000ull     // never extrapolate further than this past the last sample
+#define TOUCH_QUEUE_CAPACITY 64 // must be a power of two
+
+typedef struct {
+    float x, y; // screen pixels
+    uint64_t t_ns;
+} Touch_Sample;
+
+typedef struct {
+    Touch_Sample samples[TOUCH_HISTORY];
+    uint64_t count; // samples pushed since the last reset
+} Touch_Track;
+
+typedef enum {
+    TOUCH_DOWN,
+    TOUCH_MOVE,
+    TOUCH_UP, // also a cancelled gesture
+} Touch_Kind;
+
+typedef struct {
+    Touch_Kind kind;
+    Touch_Sample at;
+} Touch_Event;
+
+typedef struct {
+    Touch_Event events[TOUCH_QUEUE_CAPACITY];
+    uint32_t head; // next to pop
+    uint32_t tail; // next to push
+    uint32_t dropped; // events lost to a full queue
+} Touch_Queue;
+
+uint64_t input_now_ns(void);
+// forget the previous gesture, call on touch down
+void touch_reset(Touch_Track *track);
+void touch_push(Touch_Track *track, Touch_Sample sample);
+// false if nothing was pushed since the last reset
+bool touch_latest(const Touch_Track *track, Touch_Sample *sample);
+// where the finger will be at `t_ns`, from the latest sample and the
+// velocity over the last TOUCH_VELOCITY_WINDOW_NS; `t_ns` is clamped to
+// TOUCH_PREDICT_MAX_NS past the latest sample, and the result carries the
+// time it was predicted for
+bool touch_predict(const Touch_Track *track, uint64_t t_ns, Touch_Sample *predicted);
+// queues `event`, or replaces the last queued event if both are moves;
+// false if the queue was full and the event was dropped
+bool touch_queue_push(Touch_Queue *queue, Touch_Event event);
+bool touch_queue_pop(Touch_Queue *queue, Touch_Event *event);
+
+#if defined(__ANDROID__)
+#include <android/input.h>
+// pushes every sample of a touchscreen motion event onto `track`, oldest
+// first, resetting it on ACTION_DOWN, and queues the down, move or up;
+// returns false for events that aren't touchscreen motion
+bool touch_push_android(Touch_Track *track, Touch_Queue *queue, const AInputEvent *event);
+#endif
+
+#endif // INPUT_H_
+
+#ifdef INPUT_IMPLEMENTATION
+
+#include <time.h>
+
+uint64_t input_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+void touch_reset(Touch_Track *track)
+{
+    track->count = 0;
+}
+
+void touch_push(Touch_Track *track, Touch_Sample sample)
+{
+    track->samples[track->count++ & (TOUCH_HISTORY-1)] = sample;
+}
+
+bool touch_latest(const Touch_Track *track, Touch_Sample *sample)
+{
+    if (track->count == 0) return false;
+    *sample = track->samples[(track->count-1) & (TOUCH_HISTORY-1)];
+    return true;
+}
+
+bool touch_predict(const Touch_Track *track, uint64_t t_ns, Touch_Sample *predicted)
+{
+    Touch_Sample latest;
+    if (!touch_latest(track, &latest)) return false;
+    *predicted = latest;
+    if (t_ns <= latest.t_ns) return true;
+    if (t_ns - latest.t_ns > TOUCH_PREDICT_MAX_NS) t_ns = latest.t_ns + TOUCH_PREDICT_MAX_NS;
+
+    // oldest sample still inside the window
+    Touch_Sample oldest = latest;
+    size_t kept = track->count < TOUCH_HISTORY ? track->count : TOUCH_HISTORY;
+    for (size_t i = 2; i <= kept; i++) {
+        Touch_Sample s = track->samples[(track->count-i) & (TOUCH_HISTORY-1)];
+        if (latest.t_ns - s.t_ns > TOUCH_VELOCITY_WINDOW_NS) break;
+        oldest = s;
+    }
+    if (oldest.t_ns == latest.t_ns) return true; // a finger that just landed isn't going anywhere yet
+
+    float dt = (float)(latest.t_ns - oldest.t_ns);
+    float ahead = (float)(t_ns - latest.t_ns);
+    predicted->x += (latest.x - oldest.x)/dt*ahead;
+    predicted->y += (latest.y - oldest.y)/dt*ahead;
+    predicted->t_ns = t_ns;
+    return true;
+}
+
+bool touch_queue_push(Touch_Queue *queue, Touch_Event event)
+{
+    if (event.kind == TOUCH_MOVE && queue->tail != queue->head) {
+        Touch_Event *last = &queue->events[(queue->tail-1) & (TOUCH_QUEUE_CAPACITY-1)];
+        if (last->kind == TOUCH_MOVE) {
+            *last = event;
+            return true;
+        }
+    }
+    if (queue->tail - queue->head == TOUCH_QUEUE_CAPACITY) {
+        queue->dropped++;
+        return false;
+    }
+    queue->events[queue->tail++ & (TOUCH_QUEUE_CAPACITY-1)] = event;
+    return true;
+}
+
+bool touch_queue_pop(Touch_Queue *queue, Touch_Event *event)
+{
+    if (queue->head == queue->tail) return false;
+    *event = queue->events[queue->head++ & (TOUCH_QUEUE_CAPACITY-1)];
+    return true;
+}
+
+#if defined(__ANDROID__)
+bool touch_push_android(Touch_Track *track, Touch_Queue *queue, const AInputEvent *event)
+{
+    if (AInputEvent_getType(event) != AINPUT_EVENT_TYPE_MOTION) return false;
+    if ((AInputEvent_getSource(event) & AINPUT_SOURCE_TOUCHSCREEN) != AINPUT_SOURCE_TOUCHSCREEN) return false;
+    int32_t action = AMotionEvent_getAction(event) & AMOTION_EVENT_ACTION_MASK;
+    if (action == AMOTION_EVENT_ACTION_DOWN) touch_reset(track);
+    // only the first pointer drags
+    size_t history = AMotionEvent_getHistorySize(event);
+    for (size_t h = 0; h < history; h++) {
+        touch_push(track, (Touch_Sample) {
+            .x = AMotionEvent_getHistoricalX(event, 0, h),
+            .y = AMotionEvent_getHistoricalY(event, 0, h),
+            .t_ns = (uint64_t)AMotionEvent_getHistoricalEventTime(event, h),
+        });
+    }
+    Touch_Sample now = {
+        .x = AMotionEvent_getX(event, 0),
+        .y = AMotionEvent_getY(event, 0),
+        .t_ns = (uint64_t)AMotionEvent_getEventTime(event),
+    };
+    touch_push(track, now);
+    switch (action) {
+    case AMOTION_EVENT_ACTION_DOWN:   touch_queue_push(queue, (Touch_Event) { TOUCH_DOWN, now }); break;
+    case AMOTION_EVENT_ACTION_MOVE:   touch_queue_push(queue, (Touch_Event) { TOUCH_MOVE, now }); break;
+    case AMOTION_EVENT_ACTION_UP:
+    case AMOTION_EVENT_ACTION_CANCEL: touch_queue_push(queue, (Touch_Event) { TOUCH_UP, now }); break;
+    default: break; // other pointers coming and going
+    }
+    return true;
+}
+#endif
+
+#endif // INPUT_IMPLEMENTATION
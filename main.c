@@ -17,26 +17,58 @@
 *
 ********************************************************************************************/
 
+#if defined(PLATFORM_ANDROID)
 #include <android/log.h>
 #include <android/input.h>
+#endif
 
 #include "raylib.h"
 #include "raymath.h"
+#if defined(PLATFORM_ANDROID)
 #include "raymob.h"
+#endif
+#include "rlgl.h"
+
+#define PROFILER_IMPLEMENTATION
+#include "profiler.h"
+#define TRACE_IMPLEMENTATION
+#include "trace.h"
+#define SOLITAIRE_IMPLEMENTATION
+#include "solitaire.h"
+#define STATS_IMPLEMENTATION
+#include "stats.h"
+#define INPUT_IMPLEMENTATION
+#include "input.h"
+#define CARDFACE_IMPLEMENTATION
+#include "cardface.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
 #include <time.h>
 
 #define BUF_SIZE 256
 
 #define MY_LOG_TAG "UR_MOM"
 
+#if defined(PLATFORM_ANDROID)
 #define LOG_INFO(...) do { __android_log_print(ANDROID_LOG_INFO, MY_LOG_TAG, __VA_ARGS__); } while(0)
 #define LOG_DEBUG(...) do { __android_log_print(ANDROID_LOG_DEBUG, MY_LOG_TAG, __VA_ARGS__); } while(0)
+#else
+// headless host build (PLATFORM_MEMORY), used for benchmarks
+#define LOG_INFO(...) do { printf(__VA_ARGS__); printf("\n"); } while(0)
+#define LOG_DEBUG(...) do { } while(0)
+#define HOST_SCREEN_WIDTH 1080
+#define HOST_SCREEN_HEIGHT 2400
+#endif
+
+// prefix for asset paths, the host build points this at ./assets/
+#ifndef ASSETS_DIR
+#define ASSETS_DIR ""
+#endif
 
 #define TARGET_FPS 60
 #define TABLEAU_PAD 0.008f
@@ -46,16 +78,36 @@
 #define CARD_SPLAY 0.20f // in % of card_height
 #define TALON_SPLAY 0.3f 
 #define CARD_VEL 2.0f // in % screen/s ?
+#define SHOW_FRAME_GRAPH 0
+#define FRAME_REPORT_INTERVAL (TARGET_FPS*10) // frames between percentile dumps to logcat
+#define DRAW_CALL_BUDGET 80 // per frame, checked against rlGetBatchStats()
+#define TRACE_FILE "trace.json" // written to the app's internal data dir on suspend and exit
+#define RECORD_SESSION 0 // record touches to SESSION_FILE for replay with `./nob bench`
+#define SESSION_FILE "session.rae"
+#define BENCH_SETTLE_FRAMES 120 // frames run after the last replayed event
+// rcore.c keeps its AutomationEventType to itself, these are its values
+#define AUTOMATION_TOUCH_UP 14
+#define AUTOMATION_TOUCH_DOWN 15
+#define AUTOMATION_TOUCH_POSITION 16
+#define DRAW_COUNT 1 // cards turned over per tap on the reserve
+#define MAX_REDEALS REDEALS_UNLIMITED // times the talon can go back onto the reserve
+#define DRAG_SLOP 0.02f // in % screen width a touch has to travel before it counts as a drag rather than a tap
+#define DRAG_DISPLAY_LEAD_NS (1000000000ull/TARGET_FPS) // from drawing a frame to it being on screen
+#define TOUCH_LATENCY_SAMPLES 4096 // drag frames kept for the benchmark report
+#ifndef CARD_FACES_SDF
+#define CARD_FACES_SDF 0 // draw cards with cardface.h instead of the PNGs; `./nob --faces sdf` sets it and leaves the PNGs out of the APK, the host build can also pass --faces
+#endif
+#define CARD_ART_WIDTH 500 // size of the PNGs, which the SDF faces keep the aspect ratio of
+#define CARD_ART_HEIGHT 726
+#define CARD_CORNER_RADIUS 0.06f // in % of card width
+#define CARD_BACK_BORDER 0.06f // in % of card width
+#define CARD_RED CLITERAL(Color) { 200, 30, 40, 255 }
+#define CARD_BLACK CLITERAL(Color) { 20, 20, 20, 255 }
+#define CARD_EDGE_COLOR CLITERAL(Color) { 90, 90, 90, 255 }
+#define CARD_BACK_COLOR CLITERAL(Color) { 30, 60, 150, 255 }
 
 #define BACKGROUND_COLOR DARKGREEN
 
-enum face {
-    FACE_ACE = 1,
-    FACE_JACK = 11,
-    FACE_QUEEN = 12,
-    FACE_KING = 13,
-    FACE_COUNT,
-};
 const char *faceNames[] = {
     [FACE_ACE]   = "ace",
     [FACE_JACK]  = "jack",
@@ -63,14 +115,6 @@ const char *faceNames[] = {
     [FACE_KING]  = "king",
 };
 
-enum suit {
-    HEARTS,
-    CLUBS,
-    SPADES,
-    DIAMONDS,
-    SUIT_COUNT,
-};
-
 const char *suitNames[] = {
     [HEARTS]   = "hearts",
     [CLUBS]    = "clubs",
@@ -78,105 +122,115 @@ const char *suitNames[] = {
     [DIAMONDS] = "diamonds",
 };
 
-typedef struct {
-    int value;
-    enum suit suit;
-    Vector2 pos;
-    bool revealed;
-} Card;
-
-static inline bool is_black(Card c)
-{
-    return c.suit == SPADES || c.suit == CLUBS;
-}
-
-// static inline bool is_red(Card c)
-// {
-//     return !is_black(c);
-// }
+// glyph sizes the SDF faces are resolved at, see faceGlyphInk
+typedef enum {
+    GLYPH_INDEX, // rank and suit in the corner
+    GLYPH_PIP,   // number cards
+    GLYPH_ACE,
+    GLYPH_COURT, // jack, queen and king letters
+    GLYPH_SIZE_COUNT,
+} Glyph_Size;
 
+// where the pips go on a number card, x from the left column to the right
+// one, y from the top row to the bottom one; the bottom half is upside down
+#define PIPS_MAX 10
 typedef struct {
-    Card cards[52]; // size pile big enough to hold entire deck
     int count;
-} Pile;
-
-typedef struct {
-    Card *data;
-    size_t count;
-} Pile_View;
-
-void pile_append(Pile *pile, Card card) {
-    assert(pile->count < 52);
-    pile->cards[pile->count++] = card;
-}
-
-void pile_append_many(Pile *dst, const Pile *src) {
-    assert(dst->count + src->count < 52);
-    memcpy(dst->cards+dst->count, src->cards, src->count*sizeof(*src->cards));
-    dst->count += src->count;
-}
-
-Card pile_pop(Pile *pile) {
-    assert(pile->count > 0);
-    return pile->cards[--pile->count];
-}
-
-Card pile_peek(const Pile *pile) {
-    assert(pile->count > 0);
-    return pile->cards[pile->count-1];
-}
-
-Card pile_first(const Pile *pile) {
-    assert(pile->count > 0);
-    return pile->cards[0];
-}
-
-void pile_split(Pile *dst, Pile *src, size_t split)
-{
-    assert(split < src->count);
-    size_t count = src->count - split;
-    memcpy(dst->cards, src->cards+split, count*sizeof(*src->cards));
-    dst->count = count;
-    src->count = split;
-}
-
-Pile_View pile_view(Pile *src, size_t start, size_t n)
-{
-    return CLITERAL(Pile_View) {
-        .data = &src->cards[start],
-        .count = n,
-    };
-}
-
-#define TABLEAU_COLS 7
-#define FOUNDATION_COLS 4
-typedef struct {
-    Pile tableau[TABLEAU_COLS];
-    Pile foundation[FOUNDATION_COLS];
-    Pile talon;
-    Pile reserve;
-} Game;
+    Vector2 at[PIPS_MAX];
+} Pip_Layout;
 
 typedef struct {
+    Card cards[13]; // a king-to-ace run at most, `pile` is a span of this
     Pile pile;
     Vector2 start_pos;
     Vector2 end_pos;
     Pile *target;
+    Pile *source; // kept face down underneath until the run has left it for good
+    bool returning; // going back to `source`, which doesn't count as a move
     float t;
 } InFlightPile;
 
+// A run under the player's finger. It waits in pile_in_flight until it is let go
+typedef struct {
+    bool active;
+    bool moved;         // went past DRAG_SLOP, so letting go drops it instead of tapping it
+    bool tap_target;    // a tap sends it where getMoveTarget() put in pile_in_flight
+    Vector2 source_pos; // where the run sat before it was picked up
+    Vector2 grab;       // run position minus touch position
+    Vector2 press;      // touch position at pickup, pixels
+} Drag;
+
+// touch-to-swap latency of frames that drew a drag from a new touch sample
+typedef struct {
+    float raw_ms[TOUCH_LATENCY_SAMPLES];       // swap time minus sample time
+    float predicted_ms[TOUCH_LATENCY_SAMPLES]; // swap time minus the time the drag was predicted for
+    size_t count;
+    uint64_t sample_ns;    // sample drawn this frame, 0 if no drag was drawn
+    uint64_t predicted_ns;
+    uint64_t last_sample_ns;
+} Touch_Latency;
+
 // Global state
 static Game game = {0};
 static Texture2D cardTextures[14][4];
 static Texture2D cardBack;
 static Texture2D refreshIcon;
-static InFlightPile pile_in_flight;
+static bool sdf_faces = CARD_FACES_SDF;
+static Cardface_Atlas face_fields; // built once, resolved into faceAtlas at the card size
+static bool face_fields_built = false;
+static Texture2D faceAtlas; // every glyph at every Glyph_Size, and a white patch the shapes draw with
+static Rectangle faceGlyphs[GLYPH_SIZE_COUNT][CARDFACE_GLYPH_COUNT];
+static Rectangle faceBlank; // a face up card before its rank and suit go on
+static Rectangle faceBack;
+static InFlightPile pile_in_flight = { .pile.cap = 13 };
 static bool in_flight = false;
+static Drag drag = {0};
+static Touch_Track touch_track = {0};
+static Touch_Queue touch_queue = {0};
+static Touch_Latency touch_latency = {0};
 static size_t total_moves = 0;
+static uint64_t game_seed;
+static float game_time = 0.0f; // seconds played on this deal, time suspended doesn't count
+static bool game_over = false;
+static Stats_Db stats = {0};
+static bool stats_enabled = false; // off while replaying a benchmark
+
+// Lifecycle state
+// NOTE: GPU resources are released when Android takes our window away and
+// reloaded from the asset pack on the first frame after it comes back
+#if defined(PLATFORM_ANDROID)
+static void (*raylib_on_app_cmd)(struct android_app *app, int32_t cmd);
+static int32_t (*raylib_on_input_event)(struct android_app *app, AInputEvent *event);
+#endif
+static bool textures_loaded = false;
+static bool suspended = false;
+static double resume_start_time = 0.0;
+
+// Frame timing
+// NOTE: raylib is built with SUPPORT_CUSTOM_FRAME_CONTROL, so the main loop
+// swaps, paces and polls itself and GetFrameTime() is not maintained
+static Frame_Profiler profiler = {0};
+static float frame_time = 0.0f;
+static bool show_frame_graph = SHOW_FRAME_GRAPH;
+static rlBatchStats frame_batch_stats = {0};
+static rlBatchStats peak_batch_stats = {0}; // busiest frame since the last report
+#if RECORD_SESSION
+static AutomationEventList session = {0};
+#endif
+
+// Benchmark mode: replay a recorded session with a fixed timestep and no frame pacing
+typedef struct {
+    const char *session_path;
+    const char *csv_path;
+    const char *trace_path;
+    const char *screenshot_path; // last frame, for comparing how the card faces look
+    float max_frame_ms;  // p95 of update+render+swap
+    int max_draw_calls;  // busiest frame
+} Bench_Config;
 
 // useful global vars
-static int card_width_px;
-static int card_height_px;
+static int card_width_px = CARD_ART_WIDTH;
+static int card_height_px = CARD_ART_HEIGHT;
 static float card_width;
 static float card_height;
 static float card_scale;
@@ -210,86 +264,353 @@ Vector2 getTableauPos(size_t col, size_t row)
 
 bool getMoveTarget(Pile_View candidate, InFlightPile *in_flight)
 {
-    Card c = candidate.data[0];
-    in_flight->start_pos = c.pos;
+    Pile_Ref target;
+    if (!findMoveTarget(&game, candidate, &target)) return false;
+    in_flight->start_pos = candidate.data[0].pos;
     in_flight->t = 0.0f;
-    // check if move to foundation is valid
-    for (size_t i = 0; i < FOUNDATION_COLS; i++) {
-        Pile *p = &game.foundation[i];
-        in_flight->target = p;
-        in_flight->end_pos = getFoundationPos(i);
-        if (p->count == 0) {
-            if (c.value == FACE_ACE) {
-                return true;
-            }
-        } else {
-            Card last = pile_peek(p);
-            if (c.suit == last.suit && c.value == last.value + 1 && candidate.count == 1) {
-                return true;
-            }
-        }
+    in_flight->target = game_pile(&game, target);
+    if (target.kind == PILE_FOUNDATION) {
+        in_flight->end_pos = getFoundationPos(target.index);
+    } else {
+        in_flight->end_pos = getTableauPos(target.index, in_flight->target->count);
     }
+    return true;
+}
 
-    // check if move to tableau is valid
-    for (size_t i = 0; i < TABLEAU_COLS; i++) {
-        Pile *p = &game.tableau[i];
-        in_flight->target = p;
-        in_flight->end_pos = getTableauPos(i, p->count);
-        if (p->count == 0) {
-            if (c.value == FACE_KING) {
-                return true;
-            }
-        } else {
-            Card last = pile_peek(p);
-            bool different = is_black(c) ^ is_black(last);
-            if (different && c.value == last.value - 1) {
-                return true;
-            }
-        }
-    }
-    return false;
+static Texture2D loadTextureTraced(const char *fileName)
+{
+    TRACE_BEGIN("LoadTexture");
+    Texture2D texture = LoadTexture(fileName);
+    TRACE_END();
+    return texture;
 }
 
-void loadTextures() {
+// one texture per card from the PNGs
+static void loadCardArt(void)
+{
     //   all number card textures
     char texName[BUF_SIZE];
     for (int cardNum = 2; cardNum < 11; cardNum++) {
         for (enum suit suit = 0; suit < SUIT_COUNT; suit++) {
-            snprintf(texName, BUF_SIZE, "playing-cards/%d_of_%s.png", cardNum, suitNames[suit]);
-            cardTextures[cardNum][suit] = LoadTexture(texName);
+            snprintf(texName, BUF_SIZE, ASSETS_DIR "playing-cards/%d_of_%s.png", cardNum, suitNames[suit]);
+            cardTextures[cardNum][suit] = loadTextureTraced(texName);
         }
     }
 
     //   all face card textures
     //     Ace
     for (int suit = 0; suit < SUIT_COUNT; suit++) {
-        snprintf(texName, BUF_SIZE, "playing-cards/ace_of_%s.png", suitNames[suit]);
-        cardTextures[FACE_ACE][suit] = LoadTexture(texName);
+        snprintf(texName, BUF_SIZE, ASSETS_DIR "playing-cards/ace_of_%s.png", suitNames[suit]);
+        cardTextures[FACE_ACE][suit] = loadTextureTraced(texName);
     }
     //     Jack, Queen, King
     for (int cardNum = FACE_JACK; cardNum <= FACE_KING; cardNum++) {
         for (int suit = 0; suit < SUIT_COUNT; suit++) {
-            snprintf(texName, BUF_SIZE, "playing-cards/%s_of_%s.png", faceNames[cardNum], suitNames[suit]);
+            snprintf(texName, BUF_SIZE, ASSETS_DIR "playing-cards/%s_of_%s.png", faceNames[cardNum], suitNames[suit]);
             LOG_DEBUG("Trying to load tex from file: %s", texName);
-            cardTextures[cardNum][suit] = LoadTexture(texName);
+            cardTextures[cardNum][suit] = loadTextureTraced(texName);
         }
     }
     //   card back
-    Image image = LoadImage("playing-cards/card_back.png");
-    cardBack = LoadTextureFromImage(image);
-    card_width_px = image.width;
-    card_height_px = image.height;
+    cardBack = loadTextureTraced(ASSETS_DIR "playing-cards/card_back.png");
+}
+
+// glyph heights in % of card height
+static const float faceGlyphInk[GLYPH_SIZE_COUNT] = {
+    [GLYPH_INDEX] = 0.10f,
+    [GLYPH_PIP]   = 0.11f,
+    [GLYPH_ACE]   = 0.30f,
+    [GLYPH_COURT] = 0.34f,
+};
+
+static bool faceGlyphUsed(Glyph_Size size, int glyph)
+{
+    bool suit = glyph >= cardface_suit(0);
+    switch (size) {
+    case GLYPH_INDEX: return true;
+    case GLYPH_PIP:
+    case GLYPH_ACE:   return suit;
+    case GLYPH_COURT: return !suit && glyph >= cardface_rank(FACE_JACK);
+    default:          return false;
+    }
+}
+
+// paints `color` over the part of `image` at `at` through a coverage mask the size of `at`
+static void paintMask(Image *image, Rectangle at, const uint8_t *mask, Color color)
+{
+    uint8_t *pixels = image->data;
+    for (int y = 0; y < (int)at.height; y++) {
+        for (int x = 0; x < (int)at.width; x++) {
+            uint8_t *p = pixels + 4*(((int)at.y + y)*image->width + (int)at.x + x);
+            float a = mask[y*(int)at.width + x]/255.0f*color.a/255.0f;
+            float under = p[3]/255.0f*(1 - a);
+            float total = a + under;
+            if (total <= 0) continue;
+            p[0] = (uint8_t)((color.r*a + p[0]*under)/total + 0.5f);
+            p[1] = (uint8_t)((color.g*a + p[1]*under)/total + 0.5f);
+            p[2] = (uint8_t)((color.b*a + p[2]*under)/total + 0.5f);
+            p[3] = (uint8_t)(total*255 + 0.5f);
+        }
+    }
+}
+
+// every glyph the SDF faces draw, resolved at the current card size into one
+// texture along with a blank face and the back; the shapes draw from a white
+// patch of it, so the whole table is one batch on one texture; false if
+// there wasn't the memory for it
+static bool loadCardFaces(void)
+{
+    if (!face_fields_built) {
+        TRACE_BEGIN("cardface_build");
+        cardface_build(&face_fields);
+        TRACE_END();
+        face_fields_built = true;
+    }
+    TRACE_BEGIN("cardface_resolve");
+    int cell[GLYPH_SIZE_COUNT];
+    int width = 0, height = 0;
+    for (int s = 0; s < GLYPH_SIZE_COUNT; s++) {
+        cell[s] = (int)ceilf(faceGlyphInk[s]*card_height*screen_dim.y*CARDFACE_UNITS/CARDFACE_INK);
+        int row = 0;
+        for (int g = 0; g < CARDFACE_GLYPH_COUNT; g++) {
+            if (faceGlyphUsed(s, g)) row += cell[s] + 1;
+        }
+        if (row > width) width = row;
+        height += cell[s] + 1;
+    }
+    int card_w = (int)roundf(card_width*screen_dim.x);
+    int card_h = (int)roundf(card_height*screen_dim.y);
+    if (2*(card_w + 1) > width) width = 2*(card_w + 1);
+    faceBlank = CLITERAL(Rectangle) { 0, height, card_w, card_h };
+    faceBack = CLITERAL(Rectangle) { card_w + 1, height, card_w, card_h };
+    height += card_h + 1;
+    int white_y = height;
+    height += 4;
+
+    Image image = GenImageColor(width, height, CLITERAL(Color) { 255, 255, 255, 0 });
+    uint8_t *mask = malloc(card_w*card_h);
+    if (!image.data || !mask) {
+        UnloadImage(image);
+        free(mask);
+        TRACE_END();
+        return false;
+    }
+    uint8_t *pixels = image.data;
+    int y = 0;
+    for (int s = 0; s < GLYPH_SIZE_COUNT; s++) {
+        int x = 0;
+        for (int g = 0; g < CARDFACE_GLYPH_COUNT; g++) {
+            if (!faceGlyphUsed(s, g)) continue;
+            // alpha only, the color comes from the tint
+            cardface_resolve(&face_fields, g, cell[s], pixels + 4*(y*width + x) + 3, 4*width, 4);
+            faceGlyphs[s][g] = CLITERAL(Rectangle) { x, y, cell[s], cell[s] };
+            x += cell[s] + 1;
+        }
+        y += cell[s] + 1;
+    }
+
+    float radius = CARD_CORNER_RADIUS*card_w;
+    for (int back = 0; back < 2; back++) {
+        Rectangle at = back ? faceBack : faceBlank;
+        cardface_resolve_box(card_w, card_h, radius, 0, mask, card_w, 1);
+        paintMask(&image, at, mask, CARD_EDGE_COLOR);
+        cardface_resolve_box(card_w, card_h, radius - 1, 1, mask, card_w, 1);
+        paintMask(&image, at, mask, RAYWHITE);
+        if (!back) continue;
+        float border = CARD_BACK_BORDER*card_w;
+        cardface_resolve_box(card_w, card_h, fmaxf(radius - border, 0), border, mask, card_w, 1);
+        paintMask(&image, at, mask, CARD_BACK_COLOR);
+        int size = cell[GLYPH_ACE];
+        cardface_resolve(&face_fields, cardface_suit(DIAMONDS), size, mask, size, 1);
+        Rectangle pip = { at.x + (card_w - size)/2, at.y + (card_h - size)/2, size, size };
+        paintMask(&image, pip, mask, Fade(RAYWHITE, 0.25f));
+    }
+    free(mask);
+
+    for (int py = white_y; py < height; py++) {
+        for (int px = 0; px < 4; px++) pixels[4*(py*width + px) + 3] = 255;
+    }
+    faceAtlas = LoadTextureFromImage(image);
     UnloadImage(image);
+    // the middle of the patch, so filtering never reaches a glyph
+    SetShapesTexture(faceAtlas, CLITERAL(Rectangle) { 1, white_y + 1, 2, 2 });
+    TRACE_END();
+    return true;
+}
+
+static size_t textureBytes(Texture2D tex)
+{
+    return GetPixelDataSize(tex.width, tex.height, tex.format);
+}
+
+static size_t textureMemory(void)
+{
+    size_t bytes = textureBytes(refreshIcon);
+    if (sdf_faces) return bytes + textureBytes(faceAtlas);
+    for (int cardNum = 1; cardNum < 14; cardNum++) {
+        for (int suit = 0; suit < SUIT_COUNT; suit++) {
+            bytes += textureBytes(cardTextures[cardNum][suit]);
+        }
+    }
+    return bytes + textureBytes(cardBack);
+}
+
+void loadTextures() {
+    TRACE_BEGIN("loadTextures");
+    double start = GetTime();
+    if (sdf_faces && !loadCardFaces()) {
+        LOG_INFO("Could not build the SDF card faces, drawing the bitmaps instead");
+        sdf_faces = false;
+    }
+    if (!sdf_faces) loadCardArt();
 
     // refresh icon
-    image = LoadImage("refresh-page-option.png");
+    Image image = LoadImage(ASSETS_DIR "refresh-page-option.png");
     ImageResize(&image, 32, 32);
     ImageColorInvert(&image);
     refreshIcon = LoadTextureFromImage(image);
     UnloadImage(image);
+    textures_loaded = true;
+    LOG_INFO("Loaded %s card faces in %.2f ms, %zu KiB of textures", sdf_faces ? "SDF" : "bitmap",
+             (GetTime() - start)*1000.0, textureMemory()/1024);
+    TRACE_END();
+}
+
+// returns the number of bytes of texture memory released
+size_t unloadTextures(void)
+{
+    if (!textures_loaded) return 0;
+    size_t released = textureMemory();
+    if (sdf_faces) {
+        SetShapesTexture(CLITERAL(Texture2D) {0}, CLITERAL(Rectangle) {0});
+        UnloadTexture(faceAtlas);
+    } else {
+        for (int cardNum = 1; cardNum < 14; cardNum++) {
+            for (int suit = 0; suit < SUIT_COUNT; suit++) {
+                UnloadTexture(cardTextures[cardNum][suit]);
+            }
+        }
+        UnloadTexture(cardBack);
+    }
+    UnloadTexture(refreshIcon);
+    textures_loaded = false;
+    return released;
+}
+
+#if defined(PLATFORM_ANDROID)
+// Wraps raylib's own activity command handler so we can drop our textures
+// while the GL context is still current, before raylib detaches it
+static void onAppCmd(struct android_app *app, int32_t cmd)
+{
+    if (cmd == APP_CMD_TERM_WINDOW && !suspended) {
+        size_t released = unloadTextures();
+        suspended = true;
+        LOG_INFO("Suspending: released %zu KiB of texture memory", released/1024);
+        // we may not get to run again, leave a summary that covers everything logged
+        if (stats_enabled && stats.pending > 0) stats_compact(&stats);
+        if (TRACE_ENABLED && trace_write_json(TRACE_FILE)) LOG_INFO("Wrote %s", TRACE_FILE);
+#if RECORD_SESSION
+        if (ExportAutomationEventList(session, SESSION_FILE)) LOG_INFO("Wrote %s", SESSION_FILE);
+#endif
+    }
+    raylib_on_app_cmd(app, cmd);
+    if (cmd == APP_CMD_INIT_WINDOW && suspended) {
+        // raylib has re-attached the context, textures get reloaded on the next frame
+        suspended = false;
+        resume_start_time = GetTime();
+    }
+}
+
+// Wraps raylib's input handler to keep every touch sample with its timestamp,
+// where raylib only keeps the latest position
+static int32_t onInputEvent(struct android_app *app, AInputEvent *event)
+{
+    touch_push_android(&touch_track, &touch_queue, event);
+    return raylib_on_input_event(app, event);
+}
+#endif
+
+static const Pip_Layout pipLayouts[11] = {
+    [2]  = { 2,  { {0.5f, 0}, {0.5f, 1} } },
+    [3]  = { 3,  { {0.5f, 0}, {0.5f, 0.5f}, {0.5f, 1} } },
+    [4]  = { 4,  { {0, 0}, {1, 0}, {0, 1}, {1, 1} } },
+    [5]  = { 5,  { {0, 0}, {1, 0}, {0.5f, 0.5f}, {0, 1}, {1, 1} } },
+    [6]  = { 6,  { {0, 0}, {1, 0}, {0, 0.5f}, {1, 0.5f}, {0, 1}, {1, 1} } },
+    [7]  = { 7,  { {0, 0}, {1, 0}, {0.5f, 0.25f}, {0, 0.5f}, {1, 0.5f}, {0, 1}, {1, 1} } },
+    [8]  = { 8,  { {0, 0}, {1, 0}, {0.5f, 0.25f}, {0, 0.5f}, {1, 0.5f}, {0.5f, 0.75f}, {0, 1}, {1, 1} } },
+    [9]  = { 9,  { {0, 0}, {1, 0}, {0, 1/3.0f}, {1, 1/3.0f}, {0.5f, 0.5f}, {0, 2/3.0f}, {1, 2/3.0f}, {0, 1}, {1, 1} } },
+    [10] = { 10, { {0, 0}, {1, 0}, {0.5f, 1/6.0f}, {0, 1/3.0f}, {1, 1/3.0f}, {0, 2/3.0f}, {1, 2/3.0f}, {0.5f, 5/6.0f}, {0, 1}, {1, 1} } },
+};
+
+// one quad of faceAtlas, between rlBegin(RL_QUADS) and rlEnd()
+static void faceQuad(Rectangle src, Rectangle dst, bool upside_down, Color tint)
+{
+    float u0 = src.x/faceAtlas.width, u1 = (src.x + src.width)/faceAtlas.width;
+    float v0 = src.y/faceAtlas.height, v1 = (src.y + src.height)/faceAtlas.height;
+    if (upside_down) {
+        float v = v0;
+        v0 = v1;
+        v1 = v;
+    }
+    rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    rlTexCoord2f(u0, v0); rlVertex2f(dst.x, dst.y);
+    rlTexCoord2f(u0, v1); rlVertex2f(dst.x, dst.y + dst.height);
+    rlTexCoord2f(u1, v1); rlVertex2f(dst.x + dst.width, dst.y + dst.height);
+    rlTexCoord2f(u1, v0); rlVertex2f(dst.x + dst.width, dst.y);
+}
+
+// `center` in pixels; glyphs land on whole pixels since they were resolved at the size they're drawn
+static void faceGlyph(Glyph_Size size, int glyph, Vector2 center, bool upside_down, Color tint)
+{
+    Rectangle src = faceGlyphs[size][glyph];
+    Rectangle dst = { floorf(center.x - 0.5f*src.width + 0.5f), floorf(center.y - 0.5f*src.height + 0.5f), src.width, src.height };
+    faceQuad(src, dst, upside_down, tint);
+}
+
+// a card and everything on it is one run of quads, which rlsw counts as a
+// single draw call like a card PNG and GLES batches with every other card
+static void renderCardFace(Card c)
+{
+    // whole pixels, like the glyphs, so nothing gets resampled
+    Vector2 pos = { floorf(c.pos.x*screen_dim.x + 0.5f), floorf(c.pos.y*screen_dim.y + 0.5f) };
+    Rectangle blank = c.revealed ? faceBlank : faceBack;
+    float w = blank.width;
+    float h = blank.height;
+    rlCheckRenderBatchLimit(4*(1 + 2 + PIPS_MAX)); // the blank, the two index glyphs, the pips
+    rlSetTexture(faceAtlas.id);
+    rlBegin(RL_QUADS);
+    faceQuad(blank, CLITERAL(Rectangle) { pos.x, pos.y, w, h }, false, WHITE);
+    if (c.revealed) {
+        Color ink = is_black(c) ? CARD_BLACK : CARD_RED;
+        // the index has to fit in the part a splayed tableau card leaves showing
+        float index_y = pos.y + 0.075f*h;
+        faceGlyph(GLYPH_INDEX, cardface_rank(c.value), CLITERAL(Vector2) { pos.x + 0.14f*w, index_y }, false, ink);
+        faceGlyph(GLYPH_INDEX, cardface_suit(c.suit), CLITERAL(Vector2) { pos.x + 0.86f*w, index_y }, false, ink);
+
+        Vector2 center = { pos.x + 0.5f*w, pos.y + 0.6f*h };
+        if (c.value == FACE_ACE) {
+            faceGlyph(GLYPH_ACE, cardface_suit(c.suit), center, false, ink);
+        } else if (c.value >= FACE_JACK) {
+            faceGlyph(GLYPH_COURT, cardface_rank(c.value), center, false, ink);
+        } else {
+            const Pip_Layout *layout = &pipLayouts[c.value];
+            for (int i = 0; i < layout->count; i++) {
+                Vector2 at = layout->at[i];
+                Vector2 pip = { pos.x + (0.28f + 0.44f*at.x)*w, pos.y + (0.29f + 0.6f*at.y)*h };
+                faceGlyph(GLYPH_PIP, cardface_suit(c.suit), pip, at.y > 0.5f, ink);
+            }
+        }
+    }
+    rlEnd();
+    rlSetTexture(0);
 }
 
 static void renderCard(Card c) {
+    if (sdf_faces) {
+        renderCardFace(c);
+        return;
+    }
     Texture2D texture = c.revealed ? cardTextures[c.value][c.suit] : cardBack;
     DrawTextureEx(texture, Vector2Multiply(c.pos, screen_dim), 0.0f, card_scale, WHITE);
 }
@@ -299,7 +620,7 @@ void renderTableau(void)
     for (size_t i = 0; i < TABLEAU_COLS; i++) {
         const Pile *p = &game.tableau[i];
         for (size_t j = 0; j < p->count; j++) {
-            renderCard(p->cards[j]);
+            renderCard(pile_cards(game.cards, p)[j]);
         }
     }
 }
@@ -310,7 +631,7 @@ void renderFoundation(void)
     for (size_t i = 0; i < FOUNDATION_COLS; i++) {
         Pile *p = &game.foundation[i];
         if (p->count > 0) {
-            Card c = pile_peek(p);
+            Card c = pile_peek(game.cards, p);
             renderCard(c);
         } else {
             Vector2 placeholder_pos = {root_pos.x + i*(card_width+TABLEAU_PAD), root_pos.y};
@@ -332,11 +653,16 @@ static Vector2 reservePos()
     };
 }
 
+static bool canRedeal(void)
+{
+    return MAX_REDEALS == REDEALS_UNLIMITED || game.redeals < MAX_REDEALS;
+}
+
 static void renderReserve()
 {
     Vector2 root = reservePos();
     if (game.reserve.count > 0) {
-        renderCard(pile_peek(&game.reserve));
+        renderCard(pile_peek(game.cards, &game.reserve));
     } else {
         Rectangle bg_rec = {
             .x = root.x * screen_dim.x,
@@ -347,17 +673,19 @@ static void renderReserve()
         Color bg_color = GRAY;
         bg_color.a = 120;
         DrawRectangleRounded(bg_rec, 0.1, 32, bg_color);
-        Vector2 iconSize = {
-            .x = refreshIcon.width / screen_dim.x,
-            .y = refreshIcon.height / screen_dim.y,
-        };
-        Vector2 iconPos = {
-            .x = root.x + 0.5*(card_width-iconSize.x),
-            .y = root.y + 0.5*(card_height-iconSize.y),
-        };
-        Color iconColor = RAYWHITE;
-        iconColor.a = 150;
-        DrawTextureV(refreshIcon, Vector2Multiply(iconPos, screen_dim), iconColor);
+        if (canRedeal()) {
+            Vector2 iconSize = {
+                .x = refreshIcon.width / screen_dim.x,
+                .y = refreshIcon.height / screen_dim.y,
+            };
+            Vector2 iconPos = {
+                .x = root.x + 0.5*(card_width-iconSize.x),
+                .y = root.y + 0.5*(card_height-iconSize.y),
+            };
+            Color iconColor = RAYWHITE;
+            iconColor.a = 150;
+            DrawTextureV(refreshIcon, Vector2Multiply(iconPos, screen_dim), iconColor);
+        }
     }
     char textBuf[128];
     snprintf(textBuf, sizeof textBuf, "%d", game.reserve.count);
@@ -371,134 +699,313 @@ static void renderReserve()
     DrawTextEx(font, textBuf, Vector2Multiply(text_pos, screen_dim), fontSize, spacing, WHITE);
 }
 
+static void formatDuration(char *buf, size_t size, uint64_t ms)
+{
+    snprintf(buf, size, "%llu:%02llu", (unsigned long long)(ms/60000), (unsigned long long)(ms/1000%60));
+}
+
+static void renderStats(void)
+{
+    const Stats_Summary *s = &stats.summary;
+    char lines[6][128];
+    char played[32], fastest[32], average[32];
+    formatDuration(played, sizeof played, (uint64_t)(game_time*1000.0f));
+    formatDuration(fastest, sizeof fastest, s->fastest_win_ms);
+    formatDuration(average, sizeof average, s->won > 0 ? s->win_time_ms/s->won : 0);
+    snprintf(lines[0], sizeof lines[0], "Won in %s, %zu moves", played, total_moves);
+    snprintf(lines[1], sizeof lines[1], "Played %u  Won %u (%u%%)", s->played, s->won, s->played > 0 ? 100*s->won/s->played : 0);
+    snprintf(lines[2], sizeof lines[2], "Streak %u  Best %u", s->streak, s->best_streak);
+    snprintf(lines[3], sizeof lines[3], "Fastest %s  Average %s", fastest, average);
+    snprintf(lines[4], sizeof lines[4], "Fewest moves %u", s->fewest_win_moves);
+    snprintf(lines[5], sizeof lines[5], "Tap to deal again");
+
+    float fontSize = 48;
+    float spacing = 2.0;
+    float line_height = fontSize*1.4f;
+    size_t n = sizeof lines / sizeof lines[0];
+    Rectangle panel = {
+        .x = 0.1f*screen_dim.x,
+        .y = 0.5f*screen_dim.y - 0.5f*(n+1)*line_height,
+        .width = 0.8f*screen_dim.x,
+        .height = (n+1)*line_height,
+    };
+    Color bg_color = BLACK;
+    bg_color.a = 180;
+    DrawRectangleRounded(panel, 0.1, 32, bg_color);
+    for (size_t i = 0; i < n; i++) {
+        Vector2 size = MeasureTextEx(font, lines[i], fontSize, spacing);
+        Vector2 pos = { panel.x + 0.5f*(panel.width-size.x), panel.y + (i+0.5f)*line_height + 0.2f*line_height };
+        DrawTextEx(font, lines[i], pos, fontSize, spacing, WHITE);
+    }
+}
+
+static void newGame(uint64_t seed)
+{
+    LOG_INFO("Dealing game with seed %llu", (unsigned long long)seed);
+    dealGame(&game, seed);
+    game_seed = seed;
+    game_time = 0.0f;
+    total_moves = 0;
+    game_over = false;
+}
+
+// logs the current deal, won or given up on; untouched deals don't count
+static void finishGame(bool won)
+{
+    if (!stats_enabled || total_moves == 0) return;
+    Stats_Game result = {
+        .seed = game_seed,
+        .time_ms = (uint32_t)(game_time*1000.0f),
+        .moves = total_moves > UINT16_MAX ? UINT16_MAX : total_moves,
+        .won = won,
+    };
+    if (!stats_record(&stats, result)) LOG_INFO("Could not write %s", stats.log_path);
+}
+
 static float smoothstep(float x)
 {
     return 3*x*x - 2*x*x*x;
 }
 
-static void update(void)
+static bool holdingCards(void)
 {
-    // update in-flight card positions
-    if (in_flight) {
-        float t_total = Vector2Distance(pile_in_flight.start_pos, pile_in_flight.end_pos) / CARD_VEL;
-        Vector2 pile_root = Vector2Lerp(pile_in_flight.start_pos, pile_in_flight.end_pos, smoothstep(pile_in_flight.t));
-        for (size_t i = 0; i < pile_in_flight.pile.count; i++) {
-            pile_in_flight.pile.cards[i].pos = CLITERAL(Vector2) {
-                .x = pile_root.x,
-                .y = pile_root.y+i*CARD_SPLAY*card_height,
-            };
+    return in_flight || drag.active;
+}
+
+// lift `run` off `source` into the in-flight pile and start dragging it;
+// `tap_target` is what getMoveTarget() said before the run was lifted
+static void pickUp(Pile *source, size_t start, Vector2 touch_pos, Touch_Sample at, bool tap_target)
+{
+    Pile_View run = pile_split(game.cards, source, start);
+    pile_in_flight.pile.count = 0;
+    pile_append_many(pile_in_flight.cards, &pile_in_flight.pile, run);
+    pile_in_flight.source = source;
+    drag = (Drag) {
+        .active = true,
+        .tap_target = tap_target,
+        .source_pos = run.data[0].pos,
+        .grab = Vector2Subtract(run.data[0].pos, touch_pos),
+        .press = { at.x, at.y },
+    };
+}
+
+// lay the held run out under `pos`, the position of its first card
+static void placeRun(Vector2 pos)
+{
+    for (size_t i = 0; i < pile_in_flight.pile.count; i++) {
+        pile_in_flight.cards[i].pos = CLITERAL(Vector2) {
+            .x = pos.x,
+            .y = pos.y+i*CARD_SPLAY*card_height,
+        };
+    }
+}
+
+// the pile a card dropped with its center at `pos` lands on
+static bool pileAt(Vector2 pos, Pile_Ref *ref)
+{
+    for (int i = 0; i < TABLEAU_COLS; i++) {
+        Vector2 col_pos = getTableauPos(i, 0);
+        if (pos.x < col_pos.x || pos.x >= col_pos.x + card_width) continue;
+        if (pos.y >= col_pos.y - TABLEAU_TOP_MARGIN) {
+            *ref = CLITERAL(Pile_Ref) { PILE_TABLEAU, i };
+            return true;
         }
-        pile_in_flight.t += CARD_VEL*GetFrameTime()*(1/t_total);
-        if (pile_in_flight.t > 1.0f) {
-            in_flight = false;
-            pile_append_many(pile_in_flight.target, &pile_in_flight.pile);
+        Vector2 foundation_pos = getFoundationPos(i);
+        if (i < FOUNDATION_COLS && pos.y >= foundation_pos.y && pos.y < foundation_pos.y + card_height) {
+            *ref = CLITERAL(Pile_Ref) { PILE_FOUNDATION, i };
+            return true;
         }
+        return false;
     }
+    return false;
+}
 
-    Vector2 touch_pos = Vector2Divide(GetTouchPosition(0), screen_dim);
+// the finger let go: a tap sends the run where tapping always did, a drag
+// puts it where it was dropped, and anything else flies back
+static void letGo(void)
+{
+    drag.active = false;
+    Vector2 pos = pile_in_flight.cards[0].pos;
+    Pile_View run = pile_view(pile_in_flight.cards, &pile_in_flight.pile, 0, pile_in_flight.pile.count);
+    Pile_Ref ref;
+    bool placed = false;
+    if (!drag.moved) {
+        placed = drag.tap_target;
+    } else if (pileAt(Vector2Add(pos, CLITERAL(Vector2) { 0.5f*card_width, 0.5f*card_height }), &ref) &&
+               game_pile(&game, ref) != pile_in_flight.source && pileAccepts(&game, run, ref)) {
+        pile_in_flight.target = game_pile(&game, ref);
+        pile_in_flight.end_pos = ref.kind == PILE_FOUNDATION ? getFoundationPos(ref.index) : getTableauPos(ref.index, pile_in_flight.target->count);
+        placed = true;
+    }
+    if (placed) {
+        pile_in_flight.source = NULL;
+        pile_in_flight.returning = false;
+    } else {
+        pile_in_flight.target = pile_in_flight.source;
+        pile_in_flight.end_pos = drag.source_pos;
+        pile_in_flight.returning = true;
+    }
+    pile_in_flight.start_pos = pos;
+    pile_in_flight.t = 0.0f;
+    in_flight = true;
+}
 
-    // update tableau card positions
-    Vector2 root_pos = {TABLEAU_MARGIN, TABLEAU_Y_START};
-    for (size_t i = 0; i < TABLEAU_COLS; i++) {
+// a finger landed at `at`; hit-tests against where everything was drawn last frame
+static void pressAt(Touch_Sample at)
+{
+    Vector2 touch_pos = Vector2Divide(CLITERAL(Vector2) { at.x, at.y }, screen_dim);
+
+    // tableau: the splayed part of each card, all of the last one
+    for (size_t i = 0; i < TABLEAU_COLS && !holdingCards(); i++) {
         Pile *p = &game.tableau[i];
-        if (p->count > 0) {
-            p->cards[p->count-1].revealed = true;
-        }
+        Card *cards = pile_cards(game.cards, p);
         for (size_t j = 0; j < p->count; j++) {
-            p->cards[j].pos = getTableauPos(i, j);
-            // check if move can be made
-            if (!in_flight) {
-                Vector2 pos = p->cards[j].pos;
-                bool last = j == p->count-1;
-                float height = j == p->count-1 ? card_height : card_height*CARD_SPLAY;
-                Rectangle collision_box = {
-                    pos.x,
-                    pos.y,
-                    card_width,
-                    height
-                };
-
-                bool pressed = IsMouseButtonPressed(0) && CheckCollisionPointRec(touch_pos, collision_box);
-                if (pressed && getMoveTarget(pile_view(p, j, p->count-j), &pile_in_flight) && p->cards[j].revealed) {
-                    pile_split(&pile_in_flight.pile, p, j);
-                    in_flight = true;
-                }
+            float height = j == p->count-1 ? card_height : card_height*CARD_SPLAY;
+            Rectangle collision_box = { cards[j].pos.x, cards[j].pos.y, card_width, height };
+            if (cards[j].revealed && CheckCollisionPointRec(touch_pos, collision_box)) {
+                pickUp(p, j, touch_pos, at, getMoveTarget(pile_view(game.cards, p, j, p->count-j), &pile_in_flight));
+                break;
             }
         }
     }
 
-    // update foundation card positions
-    for (size_t i = 0; i < FOUNDATION_COLS; i++) {
+    // foundation tops
+    for (size_t i = 0; i < FOUNDATION_COLS && !holdingCards(); i++) {
         Pile *p = &game.foundation[i];
         Vector2 card_pos = getFoundationPos(i);
-        for (size_t j = 0; j < p->count; j++) {
-            p->cards[j].pos = card_pos;
-        }
-        if (!in_flight && p->count > 0) {
-            Rectangle collision_box = { card_pos.x, card_pos.y, card_width, card_height };
-            bool pressed = IsMouseButtonPressed(0) && CheckCollisionPointRec(touch_pos, collision_box);
-            if (pressed && getMoveTarget(pile_view(p, p->count-1, 1), &pile_in_flight)) {
-                pile_in_flight.pile.count = 0;
-                pile_append(&pile_in_flight.pile, pile_pop(p));
-                in_flight = true;
-            }
+        Rectangle collision_box = { card_pos.x, card_pos.y, card_width, card_height };
+        if (p->count > 0 && CheckCollisionPointRec(touch_pos, collision_box)) {
+            pickUp(p, p->count-1, touch_pos, at, getMoveTarget(pile_view(game.cards, p, p->count-1, 1), &pile_in_flight));
         }
     }
 
-    // update reserve
+    // reserve: draw, or turn the talon back over once it's empty; nothing
+    // lands on the talon while one of its cards is held or flying back to it
     Vector2 reserve_pos = reservePos();
-    Rectangle collision_box = {
-        reserve_pos.x,
-        reserve_pos.y,
-        card_width,
-        card_height
-    };
-    if (game.reserve.count > 0) {
-        if (IsMouseButtonPressed(0) && CheckCollisionPointRec(touch_pos, collision_box)) {
-            Card c = pile_pop(&game.reserve);
-            c.revealed = true;
-            pile_append(&game.talon, c);
+    Rectangle collision_box = { reserve_pos.x, reserve_pos.y, card_width, card_height };
+    if (pile_in_flight.source != &game.talon && CheckCollisionPointRec(touch_pos, collision_box)) {
+        if (game.reserve.count > 0) {
+            total_moves++;
+            for (int i = 0; i < DRAW_COUNT && game.reserve.count > 0; i++) {
+                Card c = pile_pop(game.cards, &game.reserve);
+                c.revealed = true;
+                pile_append(game.cards, &game.talon, c);
+            }
+        } else if (game.talon.count > 0 && canRedeal()) {
+            game_recycle_talon(&game);
+            total_moves++;
+        }
+    }
+
+    // talon top
+    if (game.talon.count > 0 && !holdingCards()) {
+        Card c = pile_peek(game.cards, &game.talon);
+        Rectangle collision_box = { c.pos.x, c.pos.y, card_width, card_height };
+        if (CheckCollisionPointRec(touch_pos, collision_box)) {
+            pickUp(&game.talon, game.talon.count-1, touch_pos, at, getMoveTarget(pile_view(game.cards, &game.talon, game.talon.count-1, 1), &pile_in_flight));
         }
-        for (size_t i = 0; i < game.reserve.count; i++) {
-            game.reserve.cards[i].pos = reserve_pos;
-            game.reserve.cards[i].revealed = false;
+    }
+}
+
+static void handleTouch(Touch_Event e)
+{
+    switch (e.kind) {
+    case TOUCH_DOWN:
+        if (game_over) {
+            uint64_t next = game_seed;
+            newGame(rng_next(&next));
+        } else {
+            pressAt(e.at);
         }
-    } else if (game.talon.count > 0 && IsMouseButtonPressed(0) && CheckCollisionPointRec(touch_pos, collision_box)) {
-        if (game.talon.count > 0) {
-            pile_split(&game.reserve, &game.talon, 0);
+        break;
+    case TOUCH_MOVE:
+        if (drag.active && Vector2Distance(CLITERAL(Vector2) { e.at.x, e.at.y }, drag.press) > DRAG_SLOP*screen_dim.x) {
+            drag.moved = true;
         }
+        break;
+    case TOUCH_UP:
+        if (drag.active) letGo();
+        break;
     }
+}
 
-    // update talon
-    if (game.talon.count > 0) {
-        Vector2 talon_root = {
-            .x = 1.0 - card_width*3 - TABLEAU_MARGIN,
-            .y = TABLEAU_Y_START - (card_height+TABLEAU_TOP_MARGIN)
-        };
-        int start = game.talon.count-3;
-        if (start < 0) start = 0;
-        for (size_t i = start; i < game.talon.count; i++) {
-            game.talon.cards[i].pos = CLITERAL(Vector2) {
-                .x = talon_root.x + (i-start)*TALON_SPLAY*card_width,
-                .y = talon_root.y
-            };
+// where every card sits this frame
+static void layout(void)
+{
+    for (size_t i = 0; i < TABLEAU_COLS; i++) {
+        Pile *p = &game.tableau[i];
+        Card *cards = pile_cards(game.cards, p);
+        if (p->count > 0 && p != pile_in_flight.source) {
+            cards[p->count-1].revealed = true;
         }
-        if (!in_flight) {
-            Card c = pile_peek(&game.talon);
-            Rectangle collision_box = {
-                .x = c.pos.x,
-                .y = c.pos.y,
-                .width = card_width,
-                .height = card_height,
-            };
-            bool pressed = IsMouseButtonPressed(0) && CheckCollisionPointRec(touch_pos, collision_box);
-            if (pressed && getMoveTarget(pile_view(&game.talon, game.talon.count-1, 1), &pile_in_flight)) {
-                pile_in_flight.pile.count = 0;
-                pile_append(&pile_in_flight.pile, pile_pop(&game.talon));
-                in_flight = true;
+        for (size_t j = 0; j < p->count; j++) {
+            cards[j].pos = getTableauPos(i, j);
+        }
+    }
+
+    for (size_t i = 0; i < FOUNDATION_COLS; i++) {
+        Pile *p = &game.foundation[i];
+        Vector2 card_pos = getFoundationPos(i);
+        for (size_t j = 0; j < p->count; j++) {
+            pile_cards(game.cards, p)[j].pos = card_pos;
+        }
+    }
+
+    Vector2 reserve_pos = reservePos();
+    Card *cards = pile_cards(game.cards, &game.reserve);
+    for (size_t i = 0; i < game.reserve.count; i++) {
+        cards[i].pos = reserve_pos;
+        cards[i].revealed = false;
+    }
+
+    Vector2 talon_root = {
+        .x = 1.0 - card_width*3 - TABLEAU_MARGIN,
+        .y = TABLEAU_Y_START - (card_height+TABLEAU_TOP_MARGIN)
+    };
+    int start = game.talon.count-3;
+    if (start < 0) start = 0;
+    for (size_t i = start; i < game.talon.count; i++) {
+        pile_cards(game.cards, &game.talon)[i].pos = CLITERAL(Vector2) {
+            .x = talon_root.x + (i-start)*TALON_SPLAY*card_width,
+            .y = talon_root.y
+        };
+    }
+}
+
+static void update(void)
+{
+    // every touch since last frame, in order, so a tap shorter than a frame still counts
+    Touch_Event e;
+    while (touch_queue_pop(&touch_queue, &e)) handleTouch(e);
+    if (game_over) return;
+    game_time += frame_time;
+
+    // the held run follows the finger, see render() for where it's drawn
+    Touch_Sample s;
+    if (drag.active && touch_latest(&touch_track, &s)) {
+        placeRun(Vector2Add(Vector2Divide(CLITERAL(Vector2) { s.x, s.y }, screen_dim), drag.grab));
+    }
+
+    // update in-flight card positions
+    if (in_flight) {
+        float t_total = Vector2Distance(pile_in_flight.start_pos, pile_in_flight.end_pos) / CARD_VEL;
+        placeRun(Vector2Lerp(pile_in_flight.start_pos, pile_in_flight.end_pos, smoothstep(pile_in_flight.t)));
+        pile_in_flight.t = t_total > 0.0f ? pile_in_flight.t + CARD_VEL*frame_time*(1/t_total) : 2.0f;
+        if (pile_in_flight.t > 1.0f) {
+            in_flight = false;
+            pile_append_many(game.cards, pile_in_flight.target, pile_view(pile_in_flight.cards, &pile_in_flight.pile, 0, pile_in_flight.pile.count));
+            pile_in_flight.source = NULL;
+            if (!pile_in_flight.returning) {
+                total_moves++;
+                if (isWon(&game)) {
+                    game_over = true;
+                    finishGame(true);
+                }
             }
         }
     }
+
+    layout();
 }
 
 void render(void)
@@ -513,98 +1020,318 @@ void render(void)
     int start = game.talon.count-3;
     if (start < 0) start = 0;
     for (size_t i = start; i < game.talon.count; i++) {
-        renderCard(game.talon.cards[i]);
+        renderCard(pile_cards(game.cards, &game.talon)[i]);
+    }
+    // a held run goes where the finger will be when this frame is on screen,
+    // from the newest touch sample rather than the position update() saw
+    touch_latency.sample_ns = 0;
+    if (drag.active) {
+        Touch_Sample latest, predicted;
+        if (touch_latest(&touch_track, &latest) &&
+            touch_predict(&touch_track, input_now_ns() + DRAG_DISPLAY_LEAD_NS, &predicted)) {
+            placeRun(Vector2Add(Vector2Divide(CLITERAL(Vector2) { predicted.x, predicted.y }, screen_dim), drag.grab));
+            touch_latency.sample_ns = latest.t_ns;
+            touch_latency.predicted_ns = predicted.t_ns;
+        }
     }
     // in flight cards
-    if (in_flight) {
+    if (holdingCards()) {
         for (size_t i = 0; i < pile_in_flight.pile.count; i++) {
-            renderCard(pile_in_flight.pile.cards[i]);
+            renderCard(pile_in_flight.cards[i]);
         }
     }
+    if (game_over) renderStats();
 }
+#if !defined(PLATFORM_ANDROID)
+static bool parseArgs(int argc, char *argv[], uint64_t *seed, Bench_Config *bench)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i+1 < argc ? argv[i+1] : NULL;
+        if (strcmp(arg, "--seed") == 0 && val) {
+            *seed = strtoull(val, NULL, 0);
+        } else if (strcmp(arg, "--bench") == 0 && val) {
+            bench->session_path = val;
+        } else if (strcmp(arg, "--csv") == 0 && val) {
+            bench->csv_path = val;
+        } else if (strcmp(arg, "--trace") == 0 && val) {
+            bench->trace_path = val;
+        } else if (strcmp(arg, "--screenshot") == 0 && val) {
+            bench->screenshot_path = val;
+        } else if (strcmp(arg, "--faces") == 0 && val && (strcmp(val, "sdf") == 0 || strcmp(val, "bitmap") == 0)) {
+            sdf_faces = strcmp(val, "sdf") == 0;
+        } else if (strcmp(arg, "--max-frame-ms") == 0 && val) {
+            bench->max_frame_ms = strtof(val, NULL);
+        } else if (strcmp(arg, "--max-draw-calls") == 0 && val) {
+            bench->max_draw_calls = atoi(val);
+        } else {
+            fprintf(stderr, "usage: %s [--seed N] [--bench session.rae [--max-frame-ms MS] [--max-draw-calls N] [--csv frames.csv] [--trace trace.json] [--screenshot last.png]] [--faces bitmap|sdf]\n", argv[0]);
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+#endif
+
+// returns false if the run went over the benchmark thresholds
+static bool benchReport(const Bench_Config *bench, size_t frames)
+{
+    Frame_Report report = prof_report(&profiler);
+    LOG_INFO("Replayed %zu frames of %s", frames, bench->session_path);
+    LOG_INFO("Frame times over all %zu frames (ms):", report.frames);
+    for (size_t s = 0; s <= STAGE_COUNT; s++) {
+        LOG_INFO("  %-6s p50 %6.2f  p95 %6.2f  p99 %6.2f",
+                 s < STAGE_COUNT ? frame_stage_names[s] : "frame",
+                 report.p50[s]*1000.0f, report.p95[s]*1000.0f, report.p99[s]*1000.0f);
+    }
+    LOG_INFO("Busiest frame: %d draw calls, %d vertices, %d texture switches",
+             peak_batch_stats.drawCalls, peak_batch_stats.vertices, peak_batch_stats.textureSwitches);
+    if (touch_latency.count > 0) {
+        size_t n = touch_latency.count;
+        qsort(touch_latency.raw_ms, n, sizeof(float), prof_cmp_float);
+        qsort(touch_latency.predicted_ms, n, sizeof(float), prof_cmp_float);
+        LOG_INFO("Touch-to-swap latency over %zu drag frames (ms):", n);
+        LOG_INFO("  sample     p50 %6.2f  p95 %6.2f", prof_percentile(touch_latency.raw_ms, n, 50),
+                 prof_percentile(touch_latency.raw_ms, n, 95));
+        LOG_INFO("  predicted  p50 %6.2f  p95 %6.2f", prof_percentile(touch_latency.predicted_ms, n, 50),
+                 prof_percentile(touch_latency.predicted_ms, n, 95));
+    }
+    if (bench->csv_path && prof_write_csv(&profiler, bench->csv_path)) LOG_INFO("Wrote %s", bench->csv_path);
+    if (bench->trace_path && trace_write_json(bench->trace_path)) LOG_INFO("Wrote %s", bench->trace_path);
+    if (bench->screenshot_path) {
+        Image last = LoadImageFromScreen();
+#if !defined(PLATFORM_ANDROID)
+        // rlsw's framebuffer reads back bottom-up and BGRA
+        ImageFlipVertical(&last);
+        uint8_t *p = last.data;
+        for (int i = 0; i < last.width*last.height; i++) {
+            uint8_t r = p[4*i];
+            p[4*i] = p[4*i + 2];
+            p[4*i + 2] = r;
+        }
+#endif
+        if (ExportImage(last, bench->screenshot_path)) LOG_INFO("Wrote %s", bench->screenshot_path);
+        UnloadImage(last);
+    }
+
+    bool ok = true;
+    // the sleep stage is always ~0 here, so the frame percentile is the work done
+    if (bench->max_frame_ms > 0 && report.p95[STAGE_COUNT]*1000.0f > bench->max_frame_ms) {
+        LOG_INFO("FAIL: p95 frame time %.2f ms exceeds %.2f ms", report.p95[STAGE_COUNT]*1000.0f, bench->max_frame_ms);
+        ok = false;
+    }
+    if (bench->max_draw_calls > 0 && peak_batch_stats.drawCalls > bench->max_draw_calls) {
+        LOG_INFO("FAIL: %d draw calls exceeds %d", peak_batch_stats.drawCalls, bench->max_draw_calls);
+        ok = false;
+    }
+    if (ok) LOG_INFO("PASS");
+    return ok;
+}
+
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main(void)
+int main(int argc, char *argv[])
 {
+    uint64_t seed = time(0);
+    Bench_Config bench = { .max_draw_calls = DRAW_CALL_BUDGET };
+#if !defined(PLATFORM_ANDROID)
+    if (!parseArgs(argc, argv, &seed, &bench)) return 1;
+#endif
+    AutomationEventList replay = {0};
+    size_t replay_next = 0;
+    size_t replay_end = 0;
+    if (bench.session_path) {
+        replay = LoadAutomationEventList(bench.session_path);
+        if (replay.count == 0) {
+            LOG_INFO("Could not load any events from %s", bench.session_path);
+            return 1;
+        }
+        replay_end = replay.events[replay.count-1].frame + BENCH_SETTLE_FRAMES;
+    }
+    // a benchmark gates on every frame it replays, not just the last PROFILER_CAPACITY
+    if (!prof_init(&profiler, bench.session_path ? replay_end + 1 : PROFILER_CAPACITY)) return 1;
+
     // Initialization
     //--------------------------------------------------------------------------------------
+#if defined(PLATFORM_ANDROID)
     InitWindow(0, 0, "raylib [core] example - basic window");
-    SetTargetFPS(TARGET_FPS);   // Set our game to run at 60 frames-per-second
+#else
+    SetTraceLogLevel(LOG_WARNING);
+    InitWindow(HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT, "solitaire");
+#endif
     screen_dim = CLITERAL(Vector2) {GetScreenWidth(), GetScreenHeight()};
     font = GetFontDefault();
     //--------------------------------------------------------------------------------------
 
     // Initialize game state
     //--------------------------------------------------------------------------------------
-    srand(time(0));
-    Pile deck = {0};
-    // Init deck
-    for (int i = 0; i < 13; i++) {
-        for (int j = 0; j < SUIT_COUNT; j++) {
-            Card c = {
-                .value = i+1,
-                .suit = j,
-                .pos = {0},
-                .revealed = false,
-            };
-            pile_append(&deck, c);
-        }
-    }
-
-    // Shuffle deck (Fisher-Yates algorithm)
-    for (int i = 51; i > 0; i--) {
-        int r = rand() % i+1; // card to swap with
-        Card tmp = deck.cards[r];
-        deck.cards[r] = deck.cards[i];
-        deck.cards[i] = tmp;
-    }
-
-    // Deal cards to foundation
-    for (int i = 0; i < TABLEAU_COLS; i++) {
-        for (int j = 0; j < i+1; j++) {
-            pile_append(&game.tableau[i], pile_pop(&deck));
-        }
-    }
-
-    // Deal remaining to reserve
-    for (int i = deck.count-1; i >= 0; i--) {
-        pile_append(&game.reserve, pile_pop(&deck));
+    newGame(seed);
+    stats_enabled = !bench.session_path;
+#if defined(PLATFORM_ANDROID)
+    const char *stats_dir = GetAndroidApp()->activity->internalDataPath; // next to TRACE_FILE
+#else
+    const char *stats_dir = ".";
+#endif
+    if (stats_enabled && !stats_open(&stats, stats_dir)) {
+        LOG_INFO("Could not read %s, not keeping stats this session", stats.log_path);
+        stats_enabled = false;
     }
     //--------------------------------------------------------------------------------------
 
-    // Loading Textures
-    //--------------------------------------------------------------------------------------
-    loadTextures();
-    //--------------------------------------------------------------------------------------
-
     card_width = (1.0 - TABLEAU_PAD*6 - TABLEAU_MARGIN*2) / 7;
     int card_width_desired_px = (int) (card_width * screen_dim.x);
     card_scale = (float) card_width_desired_px / card_width_px;
-    int card_width_scaled = card_width_px * card_scale;
     int card_height_scaled = card_height_px * card_scale;
     card_height = card_height_scaled / screen_dim.y;
 
+    // Loading Textures
+    //--------------------------------------------------------------------------------------
+    loadTextures();
+    //--------------------------------------------------------------------------------------
+
+#if defined(PLATFORM_ANDROID)
+    struct android_app *app = GetAndroidApp();
+    raylib_on_app_cmd = app->onAppCmd;
+    app->onAppCmd = onAppCmd;
+    raylib_on_input_event = app->onInputEvent;
+    app->onInputEvent = onInputEvent;
+#endif
+#if RECORD_SESSION
+    // replay needs the same seed and screen size, `./nob bench` expects HOST_SCREEN_WIDTH/HEIGHT
+    LOG_INFO("Recording session at %dx%d", GetScreenWidth(), GetScreenHeight());
+    session = LoadAutomationEventList(NULL);
+    SetAutomationEventList(&session);
+    SetAutomationEventBaseFrame(0);
+    StartAutomationEventRecording();
+#endif
+
     // Main game loop
+    double frame_start = GetTime();
+    size_t frame_count = 0;
     while (!WindowShouldClose())
     {
+        if (suspended) {
+            // no surface to draw to, just keep servicing the activity until it comes back
+            PollInputEvents();
+            WaitTime(0.1);
+            frame_start = GetTime();
+            continue;
+        }
+        if (!textures_loaded) loadTextures();
+
+        if (bench.session_path) {
+            if (frame_count >= replay_end) break;
+            while (replay_next < replay.count && replay.events[replay_next].frame <= frame_count) {
+                AutomationEvent event = replay.events[replay_next++];
+                PlayAutomationEvent(event);
+                // what the Android input callback would have seen, stamped with when it arrived
+                Vector2 touch = GetTouchPosition(0);
+                Touch_Sample sample = { touch.x, touch.y, input_now_ns() };
+                if (event.type == AUTOMATION_TOUCH_DOWN) {
+                    touch_reset(&touch_track);
+                    touch_queue_push(&touch_queue, CLITERAL(Touch_Event) { TOUCH_DOWN, sample });
+                } else if (event.type == AUTOMATION_TOUCH_POSITION) {
+                    touch_queue_push(&touch_queue, CLITERAL(Touch_Event) { TOUCH_MOVE, sample });
+                } else if (event.type == AUTOMATION_TOUCH_UP) {
+                    touch_queue_push(&touch_queue, CLITERAL(Touch_Event) { TOUCH_UP, sample });
+                }
+                if (event.type != AUTOMATION_TOUCH_UP) touch_push(&touch_track, sample);
+            }
+            frame_time = 1.0f/TARGET_FPS;
+        }
+
+        prof_begin(&profiler, STAGE_UPDATE);
+        TRACE_BEGIN("update");
         update();
+        TRACE_END();
+        prof_end(&profiler, STAGE_UPDATE);
 
+        prof_begin(&profiler, STAGE_RENDER);
+        TRACE_BEGIN("render");
+        rlResetBatchStats();
         BeginDrawing();
         ClearBackground(BACKGROUND_COLOR);
         render();
+        if (show_frame_graph) {
+            Rectangle bounds = { 0, screen_dim.y - 200, screen_dim.x, 200 };
+            prof_draw_graph(&profiler, bounds, 1.0f/TARGET_FPS);
+        }
+        // flush here so the batch submission shows up as its own scope,
+        // EndDrawing() then finds an empty batch
+        TRACE_BEGIN("rlDrawRenderBatch");
+        rlDrawRenderBatchActive();
+        TRACE_END();
         EndDrawing();
+        TRACE_END();
+        prof_end(&profiler, STAGE_RENDER);
+        frame_batch_stats = rlGetBatchStats();
+        if (frame_batch_stats.drawCalls > peak_batch_stats.drawCalls) peak_batch_stats = frame_batch_stats;
+
+        prof_begin(&profiler, STAGE_SWAP);
+        TRACE_BEGIN("SwapScreenBuffer");
+        SwapScreenBuffer();
+        TRACE_END();
+        prof_end(&profiler, STAGE_SWAP);
+        if (touch_latency.sample_ns != 0 && touch_latency.sample_ns != touch_latency.last_sample_ns &&
+            touch_latency.count < TOUCH_LATENCY_SAMPLES) {
+            uint64_t swapped = input_now_ns();
+            touch_latency.raw_ms[touch_latency.count] = (swapped - touch_latency.sample_ns)*1e-6f;
+            touch_latency.predicted_ms[touch_latency.count] = ((int64_t)swapped - (int64_t)touch_latency.predicted_ns)*1e-6f;
+            touch_latency.count++;
+            touch_latency.last_sample_ns = touch_latency.sample_ns;
+        }
+
+        prof_begin(&profiler, STAGE_SLEEP);
+        double elapsed = GetTime() - frame_start;
+        if (!bench.session_path && elapsed < 1.0/TARGET_FPS) WaitTime(1.0/TARGET_FPS - elapsed);
+        prof_end(&profiler, STAGE_SLEEP);
+
+        prof_commit(&profiler);
+        PollInputEvents();
+        double now = GetTime();
+        if (!bench.session_path) frame_time = now - frame_start;
+        frame_start = now;
+
+        if (resume_start_time > 0.0) {
+            LOG_INFO("Resumed: first frame after %.2f ms", (now - resume_start_time)*1000.0);
+            resume_start_time = 0.0;
+        }
+        if (++frame_count % FRAME_REPORT_INTERVAL == 0 && !bench.session_path) {
+            Frame_Report report = prof_report(&profiler);
+            LOG_INFO("Frame times over last %zu frames (ms):", report.frames);
+            for (size_t s = 0; s <= STAGE_COUNT; s++) {
+                LOG_INFO("  %-6s p50 %6.2f  p95 %6.2f  p99 %6.2f",
+                         s < STAGE_COUNT ? frame_stage_names[s] : "frame",
+                         report.p50[s]*1000.0f, report.p95[s]*1000.0f, report.p99[s]*1000.0f);
+            }
+            LOG_INFO("Busiest frame: %d draw calls (budget %d), %d vertices, %d texture switches, flushes: %d explicit, %d draw call limit, %d buffer overflow",
+                     peak_batch_stats.drawCalls, DRAW_CALL_BUDGET, peak_batch_stats.vertices, peak_batch_stats.textureSwitches,
+                     peak_batch_stats.flushes[RL_FLUSH_EXPLICIT], peak_batch_stats.flushes[RL_FLUSH_DRAWCALL_LIMIT],
+                     peak_batch_stats.flushes[RL_FLUSH_BUFFER_OVERFLOW]);
+            if (peak_batch_stats.drawCalls > DRAW_CALL_BUDGET) LOG_INFO("Draw call budget exceeded!");
+            peak_batch_stats = (rlBatchStats) {0};
+        }
+    }
+
+    int exit_code = 0;
+    if (bench.session_path) {
+        if (!benchReport(&bench, frame_count)) exit_code = 1;
+        UnloadAutomationEventList(replay);
     }
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
-    for (int cardNum = 1; cardNum < 14; cardNum++) {
-        for (int suit = 0; suit < SUIT_COUNT; suit++) {
-            UnloadTexture(cardTextures[cardNum][suit]);
-        }
-    }
+    if (!game_over) finishGame(false);
+    if (stats_enabled) stats_compact(&stats);
+    unloadTextures();
+    if (TRACE_ENABLED && !bench.session_path) trace_write_json(TRACE_FILE);
+#if RECORD_SESSION
+    ExportAutomationEventList(session, SESSION_FILE);
+#endif
     CloseWindow();        // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
-    return 0;
+    return exit_code;
 }
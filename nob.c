@@ -2,6 +2,10 @@
 #include "nob.h"
 #include <stdlib.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <utime.h>
+#define PROFILER_IMPLEMENTATION
+#include "profiler.h" // for prof_percentile(), so bench-profiles ranks frames the way the game does
 
 #define STR2(x) #x
 #define STR(x) STR2(x)
@@ -13,6 +17,15 @@
 #define APP_NAME       "raymob"
 #define APP_LABEL_NAME "raymob"
 
+// `./nob bench` replays BENCH_SESSION on the headless host build and fails
+// if the busiest frame or the p95 frame time goes over these limits. The host
+// build renders with rlsw on the CPU, so the frame limit is far above what a
+// device needs and only catches regressions relative to earlier runs.
+#define BENCH_SESSION        "bench/session.rae"
+#define BENCH_SEED           "1"
+#define BENCH_MAX_FRAME_MS   "70.0"
+#define BENCH_MAX_DRAW_CALLS "80"
+
 static char* home = NULL;
 static char* ndk_path = NULL;
 static char* ndk_toolchain_path = NULL;
@@ -21,27 +34,6 @@ static char* android_build_tools = NULL;
 static char* native_app_glue_path = NULL;
 static char* java_home = NULL;
 
-typedef struct {
-    Pipe *items;
-    size_t count;
-    size_t capacity;
-} Pipes;
-
-void flush_pipe(Pipe pipe, Fd outfd) {
-    static char buf[4096];
-    ssize_t n;
-    while ((n = read(pipe.read, buf, sizeof(buf))) > 0) {
-        write(outfd, buf, n);
-    }
-}
-
-void flush_pipes(Pipes *pipes, Fd outfd) {
-    for (size_t i = 0; i < pipes->count; i++) {
-        flush_pipe(pipes->items[i], outfd);
-    }
-    pipes->count = 0;
-}
-
 const char *sources[] = {
     "main.c",
 };
@@ -58,12 +50,136 @@ void cc(Cmd *cmd) {
     cmd_append(cmd, temp_sprintf("%s/bin/clang", ndk_toolchain_path));
 }
 
-void target_flags(Cmd *cmd) {
-    cmd_append(cmd, "-mfix-cortex-a53-835769");
-    cmd_append(cmd, temp_sprintf("--target=aarch64-linux-android%d", ANDROID_MIN_SDK));
+// A profile is the optimization settings the game and raylib are built with,
+// for the APK and the host alike. Each one builds under its own directory,
+// build/<profile>/ and build/host/<profile>/, so switching between them
+// rebuilds nothing; the object cache and everything Java are shared.
+typedef struct {
+    const char *name;
+    const char *flags[6];   // compile and link
+    const char *ldflags[2]; // link only
+    bool lto;               // ThinLTO where the compiler has it, full LTO elsewhere
+} Profile;
+
+static const Profile profiles[] = {
+    { .name = "debug",          .flags = { "-O0", "-g" } },
+    { .name = "release",        .flags = { "-O2", "-DNDEBUG", "-fvisibility=hidden", "-ffunction-sections", "-fdata-sections" },
+                                .ldflags = { "-Wl,--gc-sections" }, .lto = true },
+    { .name = "relwithdebinfo", .flags = { "-O2", "-g", "-DNDEBUG" } },
+};
+
+static const Profile *profile = &profiles[1]; // --profile
+
+const Profile *find_profile(const char *name) {
+    for (size_t i = 0; i < ARRAY_LEN(profiles); i++) {
+        if (strcmp(profiles[i].name, name) == 0) return &profiles[i];
+    }
+    return NULL;
+}
+
+// `./nob pgo` builds in stages, see run_pgo()
+typedef enum {
+    PGO_OFF,
+    PGO_GENERATE, // instrumented, writes profiles to PGO_RAW_DIR when it exits
+    PGO_USE,      // optimized with what PGO_GENERATE recorded
+} Pgo_Stage;
+
+#define PGO_DIR     "build/pgo"
+#define PGO_RAW_DIR PGO_DIR"/raw"
+#define PGO_STAMP   PGO_DIR"/stamp" // touched as each stage starts, so it rebuilds everything
+
+static Pgo_Stage pgo = PGO_OFF;
+static bool pgo_clang = false;            // profiles go through llvm-profdata, otherwise they're gcc's .gcda
+static const char *pgo_profdata = NULL;   // merged by llvm-profdata, named after its contents
+static uint64_t pgo_key = 0;              // hash of the profile, goes into the object cache key
+
+void pgo_flags(Cmd *cmd) {
+    switch (pgo) {
+    case PGO_OFF:
+        break;
+    case PGO_GENERATE:
+        cmd_append(cmd, "-fprofile-generate="PGO_RAW_DIR);
+        break;
+    case PGO_USE:
+        if (pgo_clang) {
+            cmd_append(cmd, temp_sprintf("-fprofile-use=%s", pgo_profdata));
+            // functions the replay never reached, or that differ from the host build
+            cmd_append(cmd, "-Wno-profile-instr-unprofiled", "-Wno-profile-instr-out-of-date");
+        } else {
+            cmd_append(cmd, "-fprofile-use="PGO_RAW_DIR, "-Wno-missing-profile");
+        }
+        break;
+    }
+}
+
+// `lto` is how the compiler at hand spells it
+void profile_flags(Cmd *cmd, const char *lto) {
+    for (size_t i = 0; i < ARRAY_LEN(profile->flags) && profile->flags[i]; i++) cmd_append(cmd, profile->flags[i]);
+    if (profile->lto) cmd_append(cmd, lto);
+    pgo_flags(cmd);
+}
+
+// on top of profile_flags()
+void profile_ldflags(Cmd *cmd) {
+    for (size_t i = 0; i < ARRAY_LEN(profile->ldflags) && profile->ldflags[i]; i++) cmd_append(cmd, profile->ldflags[i]);
+}
+
+static bool unity = false; // --unity, see graph_unity()
+// --faces sdf: the APK draws its cards from cardface.h (main.c's CARD_FACES_SDF)
+// and leaves assets/playing-cards out, see stage_sdf_assets()
+static bool sdf_faces = false;
+
+// `<root>/<profile>`, plus -pgo and -unity for builds that aren't comparable to the plain one
+const char *variant_dir(const char *root, bool pgo_build) {
+    return temp_sprintf("%s/%s%s%s", root, profile->name, pgo_build ? "-pgo" : "", unity ? "-unity" : "");
+}
+
+// where the native code of the APK goes
+const char *profile_dir(void) {
+    const char *dir = variant_dir("build", pgo == PGO_USE);
+    return sdf_faces ? temp_sprintf("%s-sdf", dir) : dir;
+}
+
+// both PGO stages build into the same place, gcc finds an object's profile by its path
+const char *host_dir(void) {
+    return variant_dir("build/host", pgo != PGO_OFF);
+}
+
+// Every ABI gets its own objects under build/<profile>/<name>/ and its own libmain.so
+// in the APK, the package manager installs whichever matches the device.
+// x86_64 is what the emulator runs, so it's also the build to set side by
+// side with the host one.
+typedef struct {
+    const char *name;   // lib/<name>/ in the APK
+    const char *triple; // clang --target, less the API level
+    const char *tuning[4];
+} Abi;
+
+static const Abi abis[] = {
+    { "arm64-v8a",   "aarch64-linux-android",    { "-mfix-cortex-a53-835769" } },
+    { "armeabi-v7a", "armv7a-linux-androideabi", { "-march=armv7-a", "-mfpu=neon", "-mthumb" } },
+    { "x86_64",      "x86_64-linux-android",     { "-march=x86-64", "-msse4.2", "-mpopcnt" } }, // the ABI guarantees SSE4.2 and POPCNT
+};
+
+typedef struct {
+    const Abi **items;
+    size_t count;
+    size_t capacity;
+} Abi_List;
+
+const Abi *find_abi(const char *name) {
+    for (size_t i = 0; i < ARRAY_LEN(abis); i++) {
+        if (strcmp(abis[i].name, name) == 0) return &abis[i];
+    }
+    return NULL;
+}
+
+void target_flags(Cmd *cmd, const Abi *abi) {
+    for (size_t i = 0; i < ARRAY_LEN(abi->tuning) && abi->tuning[i]; i++) cmd_append(cmd, abi->tuning[i]);
+    cmd_append(cmd, temp_sprintf("--target=%s%d", abi->triple, ANDROID_MIN_SDK));
     cmd_append(cmd, temp_sprintf("--sysroot=%s/sysroot", ndk_toolchain_path));
 }
-void ldflags(Cmd *cmd) {
+void ldflags(Cmd *cmd, const Abi *abi) {
     cmd_append(cmd, "-Wl,-soname,libmain.so");
     cmd_append(cmd, "-Wl,--exclude-libs,libatomic.a"); // not sure why this is needed, but it was in the raylib Makefile.Android
     cmd_append(cmd, "-Wl,--build-id"); // likewise
@@ -76,17 +192,53 @@ void ldflags(Cmd *cmd) {
     cmd_append(cmd, "-Wl,--fatal-warnings");
     cmd_append(cmd, "-Wl,--wrap=fopen");
     cmd_append(cmd, "-u","ANativeActivity_onCreate");
-    cmd_append(cmd, "-L./build/");
-    cmd_append(cmd, "-L./build/lib");
+    cmd_append(cmd, temp_sprintf("-L./%s/%s", profile_dir(), abi->name));
+    profile_flags(cmd, "-flto=thin");
+    profile_ldflags(cmd);
 }
 
+// raylib's config.h only sets what isn't defined yet, so whatever
+// RAYLIB_CONFIG defines wins. It turns off the parts of raylib the game never
+// calls: models and audio (miniaudio alone is most of raudio.o), the 3D camera,
+// and every image and font loader but PNG and the built-in default font.
+// Screenshots and --screenshot still need PNG export.
+#define RAYLIB_CONFIG "build/raylib_config.h"
+
+static const char *raylib_config[][2] = {
+    { "SUPPORT_MODULE_RMODELS",   "0" },
+    { "SUPPORT_MODULE_RAUDIO",    "0" },
+    { "SUPPORT_CAMERA_SYSTEM",    "0" },
+    { "SUPPORT_COMPRESSION_API",  "0" },
+    { "SUPPORT_CLIPBOARD_IMAGE",  "0" },
+    { "SUPPORT_IMAGE_GENERATION", "0" },
+    { "SUPPORT_FILEFORMAT_PNG",   "1" },
+    { "SUPPORT_FILEFORMAT_BMP",   "0" },
+    { "SUPPORT_FILEFORMAT_TGA",   "0" },
+    { "SUPPORT_FILEFORMAT_JPG",   "0" },
+    { "SUPPORT_FILEFORMAT_GIF",   "0" },
+    { "SUPPORT_FILEFORMAT_QOI",   "0" },
+    { "SUPPORT_FILEFORMAT_PSD",   "0" },
+    { "SUPPORT_FILEFORMAT_DDS",   "0" },
+    { "SUPPORT_FILEFORMAT_HDR",   "0" },
+    { "SUPPORT_FILEFORMAT_PIC",   "0" },
+    { "SUPPORT_FILEFORMAT_PNM",   "0" },
+    { "SUPPORT_FILEFORMAT_KTX",   "0" },
+    { "SUPPORT_FILEFORMAT_ASTC",  "0" },
+    { "SUPPORT_FILEFORMAT_PKM",   "0" },
+    { "SUPPORT_FILEFORMAT_PVR",   "0" },
+    { "SUPPORT_FILEFORMAT_TTF",   "0" },
+    { "SUPPORT_FILEFORMAT_FNT",   "0" },
+    { "SUPPORT_FILEFORMAT_BDF",   "0" },
+};
+
 void includes(Cmd *cmd) {
     cmd_append(cmd, temp_sprintf("-I%s", native_app_glue_path));
     cmd_append(cmd, "-I./deps/raylib-6.0/src");
     cmd_append(cmd, "-I./deps/raymob/");
+    cmd_append(cmd, "-include", RAYLIB_CONFIG);
 }
 
-void cflags(Cmd *cmd) {
+void cflags(Cmd *cmd, const Abi *abi) {
     if (isatty(STDERR_FILENO))
         cmd_append(cmd, "-fcolor-diagnostics");
     cmd_append(cmd, "-Wall");
@@ -95,6 +247,8 @@ void cflags(Cmd *cmd) {
     cmd_append(cmd, "-std=c99");
     cmd_append(cmd, "-D_GNU_SOURCE");
     cmd_append(cmd, "-DGRAPHICS_API_OPENGL_ES2");
+    cmd_append(cmd, "-DSUPPORT_CUSTOM_FRAME_CONTROL=1"); // main loop does its own swap/pacing/polling so each can be timed
+    if (sdf_faces) cmd_append(cmd, "-DCARD_FACES_SDF=1");
     cmd_append(cmd, "-ffunction-sections");
     cmd_append(cmd, "-funwind-tables");
     cmd_append(cmd, "-fstack-protector-strong");
@@ -102,13 +256,18 @@ void cflags(Cmd *cmd) {
     cmd_append(cmd, "-no-canonical-prefixes");
     cmd_append(cmd, "-DANDROID");
     cmd_append(cmd, "-DPLATFORM_ANDROID");
-    target_flags(cmd);
+    profile_flags(cmd, "-flto=thin");
+    target_flags(cmd, abi);
 }
 
-bool create_temp_project_dirs() {
+bool create_temp_project_dirs(const Abi_List *targets) {
     if (!mkdir_if_not_exists("build")) return false;
-    if (!mkdir_if_not_exists("build/lib")) return false;
-    if (!mkdir_if_not_exists("build/lib/arm64-v8a")) return false;
+    if (!mkdir_if_not_exists(profile_dir())) return false;
+    if (!mkdir_if_not_exists(temp_sprintf("%s/lib", profile_dir()))) return false;
+    for (size_t i = 0; i < targets->count; i++) {
+        if (!mkdir_if_not_exists(temp_sprintf("%s/lib/%s", profile_dir(), targets->items[i]->name))) return false;
+        if (!mkdir_if_not_exists(temp_sprintf("%s/%s", profile_dir(), targets->items[i]->name))) return false;
+    }
     if (!mkdir_if_not_exists("build/bin")) return false;
     if (!mkdir_if_not_exists("build/compiled")) return false;
     return true;
@@ -127,22 +286,6 @@ bool create_temp_project_dirs() {
 //     nob_log(NOB_INFO, "TODO: generate_android_manifest\n");
 //     return false;
 // }
-bool generate_apk_keystore(Cmd *cmd) {
-    const char *keystore = "build/"APP_NAME".keystore";
-    if (!file_exists(keystore)) {
-        cmd_append(cmd, java_bin("keytool"));
-        cmd_append(cmd, "-genkeypair");
-        cmd_append(cmd, "-validity", "10000");
-        cmd_append(cmd, "-dname", "CN="APP_AUTHOR",O=Android,C=ES");
-        cmd_append(cmd, "-keystore", keystore);
-        cmd_append(cmd, "-storepass", "foobar");
-        cmd_append(cmd, "-alias", APP_NAME"Key");
-        cmd_append(cmd, "-keyalg", "RSA");
-        if (!cmd_run(cmd)) return false;
-    }
-    return true;
-}
-
 bool collect_regular_files(Walk_Entry entry) {
     File_Paths *files = entry.data;
     if (entry.type == FILE_REGULAR) {
@@ -151,66 +294,619 @@ bool collect_regular_files(Walk_Entry entry) {
     return true;
 }
 
-bool config_project_package(Cmd *cmd, Procs *procs) {
-    // this step generates a starting APK with resources + R.java for loading
-    // outputs: R.java, resources.apk
-    bool result = true;
-    size_t checkpoint = temp_save();
-    const char *apk_path = "build/bin/resources.apk";
-    File_Paths files = {0};
+const char *objname(const char *srcname) {
+    String_View sv = sv_from_cstr(srcname);
+    String_View name = {0};
+    while (sv.count > 0) {
+        name = sv_chop_by_delim(&sv, '/');
+    }
+    name = sv_chop_by_delim(&name, '.');
+    return temp_sprintf(SV_Fmt".o", SV_Arg(name));
+}
 
-    // collect all res and asset files that get bundled into the resources.apk
-    walk_dir("./res", collect_regular_files, .data = &files);
-    walk_dir("./assets", collect_regular_files, .data = &files);
-    // also include the AndroidManifest.xml
-    da_append(&files, "AndroidManifest.xml");
-    // if any of them are newer than output APK, rebuild
-    if (needs_rebuild(apk_path, files.items, files.count)) {
-        nob_log(NOB_INFO, "assets files have changed, rebuilding %s", apk_path);
-        /**** aapt2 compile step ****/
-        // res files
-        files.count = 0;
-        walk_dir("./res", collect_regular_files, .data = &files);
-        for (size_t i = 0; i < files.count; i++) {
-            cmd_append(cmd, temp_sprintf("%s/aapt2", android_build_tools));
-            cmd_append(cmd, "compile");
-            cmd_append(cmd, files.items[i]);
-            cmd_append(cmd, "-o", "build/compiled");
-            if (!cmd_run(cmd, .async = procs)) return_defer(false);
+// -1 if it can't be stat'ed
+long file_size(const char *path) {
+    struct stat st;
+    if (stat(path, &st) < 0) return -1;
+    return (long)st.st_size;
+}
+
+// leaves `path` alone if it already holds `sb`, so a generated file that
+// didn't change doesn't look changed to needs_rebuild()
+bool write_if_changed(const char *path, const String_Builder *sb) {
+    String_Builder old = {0};
+    bool same = file_exists(path) == 1 && read_entire_file(path, &old) &&
+        old.count == sb->count && memcmp(old.items, sb->items, sb->count) == 0;
+    sb_free(old);
+    return same || write_entire_file(path, sb->items, sb->count);
+}
+
+// ELF and zip are both little-endian whatever the host is
+static uint64_t get_le(const uint8_t *p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint64_t)p[i] << 8*i;
+    return v;
+}
+
+static void put_le(String_Builder *sb, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) da_append(sb, (char)(v >> 8*i));
+}
+
+// The dynamic relocations in a little-endian ELF file, which the loader has
+// to apply before any of its code runs; -1 if it can't be read. Counts
+// packed relocations too: RELR bitmaps and Android's APS2 (whose count
+// leads the stream).
+long elf_relocations(const char *path) {
+    String_Builder sb = {0};
+    if (!read_entire_file(path, &sb)) return -1;
+    const uint8_t *elf = (const uint8_t *)sb.items;
+    long count = -1;
+    if (sb.count < 64 || memcmp(elf, "\x7f""ELF", 4) != 0 || elf[5] != 1) goto done;
+    bool is64 = elf[4] == 2;
+    int word = is64 ? 8 : 4;
+    uint64_t shoff = is64 ? get_le(elf + 40, 8) : get_le(elf + 32, 4);
+    uint64_t shentsize = get_le(elf + (is64 ? 58 : 46), 2);
+    uint64_t shnum = get_le(elf + (is64 ? 60 : 48), 2);
+    if (shoff + shnum*shentsize > sb.count) goto done;
+    count = 0;
+    for (uint64_t i = 0; i < shnum; i++) {
+        const uint8_t *sh = elf + shoff + i*shentsize;
+        uint32_t type = (uint32_t)get_le(sh + 4, 4);
+        uint64_t flags = get_le(sh + 8, word);
+        uint64_t offset = get_le(sh + (is64 ? 24 : 16), word);
+        uint64_t size = get_le(sh + (is64 ? 32 : 20), word);
+        uint64_t entsize = get_le(sh + (is64 ? 56 : 36), word);
+        if (!(flags & 2) || offset + size > sb.count) continue; // only what gets loaded (SHF_ALLOC)
+        const uint8_t *data = elf + offset;
+        switch (type) {
+        case 4: // SHT_RELA
+        case 9: // SHT_REL
+            if (entsize) count += (long)(size/entsize);
+            break;
+        case 19:         // SHT_RELR
+        case 0x6fffff00: // SHT_ANDROID_RELR
+            // an address is one relocation, a bitmap (low bit set) one per other bit set
+            for (uint64_t at = 0; at + word <= size; at += word) {
+                uint64_t entry = get_le(data + at, word);
+                count += (entry & 1) ? __builtin_popcountll(entry) - 1 : 1;
+            }
+            break;
+        case 0x60000001: // SHT_ANDROID_REL
+        case 0x60000002: // SHT_ANDROID_RELA
+            // "APS2", then the count as a SLEB128
+            if (size > 4 && memcmp(data, "APS2", 4) == 0) {
+                uint64_t n = 0;
+                int shift = 0;
+                for (uint64_t at = 4; at < size && shift < 64; at++, shift += 7) {
+                    n |= (uint64_t)(data[at] & 0x7f) << shift;
+                    if (!(data[at] & 0x80)) break;
+                }
+                count += (long)n;
+            }
+            break;
         }
-        if (!procs_flush(procs)) return_defer(false);
+    }
+done:
+    sb_free(sb);
+    return count;
+}
 
-        /**** aapt2 link step ****/
-        // grab the generated *.flat files form the compile step
-        files.count = 0;
-        walk_dir("./build/compiled", collect_regular_files, .data = &files);
-        cmd_append(cmd, temp_sprintf("%s/aapt2", android_build_tools));
-        cmd_append(cmd, "link");
-        cmd_append(cmd, "--min-sdk-version", STR(ANDROID_MIN_SDK));
-        cmd_append(cmd, "--target-sdk-version", STR(ANDROID_TARGET_SDK));
-        cmd_append(cmd, "-o", apk_path);
-        cmd_append(cmd, "--java", "build/gen/");
-        cmd_append(cmd, "-I", temp_sprintf("%s/platforms/android-%d/android.jar", sdk_path, ANDROID_TARGET_SDK));
-        da_append_many(cmd, files.items, files.count);
-        cmd_append(cmd, "--manifest", "AndroidManifest.xml");
-        cmd_append(cmd, "-A", "assets");
-        // cmd_append(cmd, "-v");
-        if (!cmd_run(cmd)) return_defer(false);
+void log_size(const char *path) {
+    long relocations = elf_relocations(path);
+    if (relocations < 0) {
+        nob_log(NOB_INFO, "%s: %ld KiB (%s)", path, file_size(path)/1024, profile->name);
+    } else {
+        nob_log(NOB_INFO, "%s: %ld KiB, %ld relocations (%s)", path, file_size(path)/1024, relocations, profile->name);
     }
+}
+
+/**** Incremental builds ****/
+// Every compile writes a depfile (-MMD) next to its output listing the
+// sources and headers the compiler actually read, and the next build checks
+// those instead of a hand-kept list, so editing raylib.h or config.h rebuilds
+// exactly the objects that include it.
+
+void depfile_flags(Cmd *cmd, const char *out) {
+    cmd_append(cmd, "-MMD", "-MF", temp_sprintf("%s.d", out));
+}
+
+// Make syntax as written by gcc and clang: `target: dep dep \` with
+// continuation lines, spaces in paths escaped with a backslash
+bool read_depfile(const char *path, File_Paths *deps) {
+    String_Builder sb = {0};
+    if (!read_entire_file(path, &sb)) return false;
+    size_t i = 0;
+    // skip the target
+    while (i < sb.count && !(sb.items[i] == ':' && (i+1 == sb.count || isspace((unsigned char)sb.items[i+1])))) i++;
+    i++;
+    String_Builder name = {0};
+    while (i < sb.count) {
+        char c = sb.items[i++];
+        if (c == '\\' && i < sb.count && (sb.items[i] == '\n' || sb.items[i] == '\r')) continue;
+        if (c == '\\' && i < sb.count && sb.items[i] == ' ') {
+            da_append(&name, ' ');
+            i++;
+            continue;
+        }
+        if (isspace((unsigned char)c)) {
+            if (name.count > 0) {
+                da_append(deps, temp_sprintf("%.*s", (int)name.count, name.items));
+                name.count = 0;
+            }
+            continue;
+        }
+        da_append(&name, c);
+    }
+    if (name.count > 0) da_append(deps, temp_sprintf("%.*s", (int)name.count, name.items));
+    da_free(name);
+    da_free(sb);
+    return true;
+}
+
+// `out` is stale if it or its depfile is missing, or if anything the depfile
+// or `extra` (libraries linked in, say) lists is newer or gone
+bool needs_rebuild_deps(const char *out, const char **extra, size_t extra_count) {
+    if (!file_exists(out)) return true;
+    File_Paths deps = {0};
+    bool stale = true;
+    size_t checkpoint = temp_save();
+    if (!read_depfile(temp_sprintf("%s.d", out), &deps)) goto defer;
+    da_append_many(&deps, extra, extra_count);
+    for (size_t i = 0; i < deps.count; i++) {
+        if (file_exists(deps.items[i]) != 1) goto defer; // a header went away, let the compiler say if it matters
+    }
+    stale = needs_rebuild(out, deps.items, deps.count) != 0;
 defer:
     temp_rewind(checkpoint);
-    da_free(files);
-    return result;
+    da_free(deps);
+    return stale;
 }
 
-const char *objname(const char *srcname) {
-    String_View sv = sv_from_cstr(srcname);
-    String_View name = {0};
-    while (sv.count > 0) {
-        name = sv_chop_by_delim(&sv, '/');
+/**** Object cache ****/
+// Objects are also kept in CACHE_DIR under a hash of the preprocessed source
+// and the whole compile command, compiler path and flags included. When the
+// timestamps say an object is stale but nothing it's made of really changed
+// (a branch switch, a fresh checkout, a deleted object) it's copied back
+// instead of compiled. Preprocessing costs a fraction of a compile and
+// writes the depfile as well, so a restored object still tracks its headers.
+
+#define CACHE_DIR "build/cache"
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t size) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
     }
-    name = sv_chop_by_delim(&name, '.');
-    return temp_sprintf(SV_Fmt".o", SV_Arg(name));
+    return h;
+}
+
+// `compile` is a complete `-c <src> -o <out>` command and is left untouched.
+// Appends its preprocessor run, writing to `pre`, to `cmd` and returns the
+// part of the cache key that comes from the command itself
+uint64_t cache_preprocess(const Cmd *compile, const char *pre, Cmd *cmd) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < compile->count; i++) {
+        const char *arg = compile->items[i];
+        // where the object and its depfile go doesn't change what's in it
+        if (strcmp(arg, "-o") == 0 && i+1 < compile->count) {
+            i++;
+            continue;
+        }
+        da_append(cmd, arg);
+        if (strcmp(arg, "-MF") == 0 && i+1 < compile->count) {
+            da_append(cmd, compile->items[++i]);
+            continue;
+        }
+        h = fnv1a(h, arg, strlen(arg) + 1);
+    }
+    // the profile isn't on the command line, only where it is
+    if (pgo == PGO_USE) h = fnv1a(h, &pgo_key, sizeof(pgo_key));
+    cmd_append(cmd, "-E", "-o", pre);
+    return h;
+}
+
+// finishes the key from cache_preprocess() with the preprocessed source,
+// removing `pre`. Returns where `out` is cached, or NULL if `pre` can't be
+// read; `*hit` is set if `out` was restored from there
+const char *cache_lookup(uint64_t key, const char *pre, const char *out, bool *hit) {
+    *hit = false;
+    String_Builder sb = {0};
+    const char *path = NULL;
+    if (!read_entire_file(pre, &sb)) goto defer;
+    key = fnv1a(key, sb.items, sb.count);
+    path = temp_sprintf(CACHE_DIR"/%016llx.o", (unsigned long long)key);
+    if (file_exists(path) == 1 && copy_file(path, out)) *hit = true;
+defer:
+    delete_file(pre);
+    da_free(sb);
+    return path;
+}
+
+// after `out` compiled, keep it under `path` from cache_lookup()
+bool cache_store(const char *out, const char *path) {
+    if (!path) return true;
+    // a copy cut short must never be found under the real name
+    const char *tmp = temp_sprintf("%s.tmp", path);
+    return copy_file(out, tmp) && nob_rename(tmp, path);
+}
+
+/**** Build graph ****/
+// A build is a graph of steps, each running at most one command, and a step
+// starts as soon as everything it depends on is done, up to nob_nprocs() at a
+// time. That way the native, Java and resource chains of the APK overlap
+// instead of queueing behind each other. A step decides whether it has
+// anything to do only once its dependencies are done, because their outputs
+// are what it compares against. Whatever a command prints goes to a log in
+// LOG_DIR that is copied to stderr when it exits, so messages from parallel
+// jobs don't interleave. When more steps are ready than there are jobs, the
+// ones added to the graph first start first.
+//
+// Steps allocate their commands from the temporary arena, so callers rewind
+// it only after graph_run() returns.
+//
+// Every run leaves a report next to the logs: <build>.txt has each step's
+// start and duration and the critical path, the chain of steps that each
+// waited on the one before and ended the build last, and <build>.json has the
+// same as a Chrome trace (chrome://tracing, ui.perfetto.dev) with a row per
+// job. The critical path is also printed, since that's what to make faster.
+
+#define LOG_DIR "build/logs"
+
+typedef enum {
+    STEP_WAITING,
+    STEP_RUNNING,
+    STEP_DONE,
+    STEP_FAILED,
+} Step_State;
+
+typedef struct Step Step;
+
+// appends the step's command to `cmd`, or leaves it empty if the output is
+// up to date or the step did its work itself (setting `step->ran`)
+typedef bool (*Step_Plan)(Step *step, Cmd *cmd);
+// after the step's command exited successfully
+typedef bool (*Step_Finish)(Step *step);
+
+struct Step {
+    const char *name;
+    Step_Plan plan;
+    Step_Finish finish; // optional
+    void *data;
+    struct {
+        size_t *items; // indices of the steps this one waits for
+        size_t count;
+        size_t capacity;
+    } deps;
+    Step_State state;
+    Proc proc;
+    bool ran;
+    size_t job;          // 1..jobs for a command, 0 if it ran in-process or didn't run
+    uint64_t started_ns; // from when the scheduler got to it
+    uint64_t elapsed_ns;
+};
+
+typedef struct {
+    Step *items;
+    size_t count;
+    size_t capacity;
+} Graph;
+
+size_t graph_step(Graph *g, const char *name, Step_Plan plan, Step_Finish finish, void *data) {
+    da_append(g, ((Step) { .name = name, .plan = plan, .finish = finish, .data = data }));
+    return g->count - 1;
+}
+
+void graph_dep(Graph *g, size_t step, size_t dep) {
+    da_append(&g->items[step].deps, dep);
+}
+
+void graph_free(Graph *g) {
+    for (size_t i = 0; i < g->count; i++) da_free(g->items[i].deps);
+    da_free(*g);
+}
+
+static bool step_ready(const Graph *g, const Step *step) {
+    for (size_t i = 0; i < step->deps.count; i++) {
+        if (g->items[step->deps.items[i]].state != STEP_DONE) return false;
+    }
+    return true;
+}
+
+static const char *step_log(const Graph *g, const Step *step) {
+    return temp_sprintf(LOG_DIR"/%zu.log", (size_t)(step - g->items));
+}
+
+static bool step_start(Graph *g, Step *step, Cmd *cmd) {
+    const char *log = step_log(g, step);
+    Fd out = fd_open_for_write(log);
+    if (out == INVALID_FD) return false;
+    // cmd_run() closes both descriptors it's given
+    Fd err = dup(out);
+    Procs procs = {0};
+    bool ok = cmd_run(cmd, .async = &procs, .stdout_fd = out, .stderr_fd = err);
+    if (ok) step->proc = procs.items[0];
+    da_free(procs);
+    return ok;
+}
+
+static void step_print_log(const Graph *g, const Step *step) {
+    String_Builder sb = {0};
+    if (read_entire_file(step_log(g, step), &sb)) fwrite(sb.items, 1, sb.count, stderr);
+    da_free(sb);
+}
+
+static void json_escape(String_Builder *sb, const char *s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') da_append(sb, '\\');
+        da_append(sb, *s);
+    }
+}
+
+static int compare_step_starts(const void *a, const void *b) {
+    const Step *x = *(const Step **)a, *y = *(const Step **)b;
+    return (x->started_ns > y->started_ns) - (x->started_ns < y->started_ns);
+}
+
+// LOG_DIR/<what>.<ext>, `what` with its spaces turned to dashes
+static const char *graph_report_path(const char *what, const char *ext) {
+    char *path = temp_sprintf(LOG_DIR"/%s.%s", what, ext);
+    for (char *c = path; *c; c++) if (*c == ' ') *c = '-';
+    return path;
+}
+
+// see the top of the section; `start` is when graph_run() started
+void graph_report(const Graph *g, const char *what, uint64_t start, size_t jobs) {
+    double total = 0;
+    for (size_t i = 0; i < g->count; i++) {
+        const Step *step = &g->items[i];
+        if (step->state == STEP_DONE || step->state == STEP_FAILED) {
+            double end = (double)(step->started_ns + step->elapsed_ns - start)/NOB_NANOS_PER_SEC;
+            if (end > total) total = end;
+        }
+    }
+
+    // from the step that finished last, back through whichever dependency finished last
+    Step **path = temp_alloc(g->count*sizeof(*path));
+    size_t path_len = 0;
+    const Step *at = NULL;
+    for (size_t i = 0; i < g->count; i++) {
+        const Step *step = &g->items[i];
+        if (step->state != STEP_DONE && step->state != STEP_FAILED) continue;
+        if (!at || step->started_ns + step->elapsed_ns > at->started_ns + at->elapsed_ns) at = step;
+    }
+    while (at) {
+        path[path_len++] = (Step *)at;
+        const Step *prev = NULL;
+        for (size_t i = 0; i < at->deps.count; i++) {
+            const Step *dep = &g->items[at->deps.items[i]];
+            if (!prev || dep->started_ns + dep->elapsed_ns > prev->started_ns + prev->elapsed_ns) prev = dep;
+        }
+        at = prev;
+    }
+    // what's left of the wall time went to waiting for a free job after the step before was done
+    double path_secs = 0, waited_secs = 0;
+    double *waited = temp_alloc(g->count*sizeof(*waited));
+    for (size_t i = 0; i < path_len; i++) {
+        uint64_t ready = i + 1 < path_len ? path[i+1]->started_ns + path[i+1]->elapsed_ns : start;
+        waited[i] = path[i]->started_ns > ready ? (double)(path[i]->started_ns - ready)/NOB_NANOS_PER_SEC : 0;
+        path_secs += (double)path[i]->elapsed_ns/NOB_NANOS_PER_SEC;
+        waited_secs += waited[i];
+    }
+
+    String_Builder sb = {0};
+    sb_appendf(&sb, "%s: %.2fs, %zu jobs at a time\n\n", what, total, jobs);
+    sb_appendf(&sb, "   start      took  step\n");
+    const Step **by_start = temp_alloc(g->count*sizeof(*by_start));
+    size_t settled = 0;
+    for (size_t i = 0; i < g->count; i++) {
+        if (g->items[i].state == STEP_DONE || g->items[i].state == STEP_FAILED) by_start[settled++] = &g->items[i];
+    }
+    qsort(by_start, settled, sizeof(*by_start), compare_step_starts);
+    for (size_t i = 0; i < settled; i++) {
+        const Step *step = by_start[i];
+        sb_appendf(&sb, "%7.2fs  %7.2fs  %s%s\n", (double)(step->started_ns - start)/NOB_NANOS_PER_SEC,
+                   (double)step->elapsed_ns/NOB_NANOS_PER_SEC, step->name, step->ran ? "" : " (up to date)");
+    }
+    sb_appendf(&sb, "\ncritical path of the %.2fs: %.2fs running, %.2fs waiting for a free job\n", total, path_secs, waited_secs);
+    sb_appendf(&sb, "  waited      took  step\n");
+    for (size_t i = path_len; i > 0; i--) {
+        sb_appendf(&sb, "%7.2fs  %7.2fs  %s%s\n", waited[i-1], (double)path[i-1]->elapsed_ns/NOB_NANOS_PER_SEC,
+                   path[i-1]->name, path[i-1]->ran ? "" : " (up to date)");
+    }
+    const char *txt = graph_report_path(what, "txt");
+    write_entire_file(txt, sb.items, sb.count);
+
+    sb.count = 0;
+    sb_append_cstr(&sb, "{\"traceEvents\":[\n");
+    for (size_t j = 0; j <= jobs; j++) {
+        sb_appendf(&sb, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":", j);
+        if (j == 0) sb_appendf(&sb, "\"nob\"}},\n");
+        else sb_appendf(&sb, "\"job %zu\"}},\n", j);
+    }
+    bool first = true;
+    for (size_t i = 0; i < g->count; i++) {
+        const Step *step = &g->items[i];
+        if (step->state != STEP_DONE && step->state != STEP_FAILED) continue;
+        sb_appendf(&sb, "%s{\"name\":\"", first ? "" : ",\n");
+        json_escape(&sb, step->name);
+        sb_appendf(&sb, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"ran\":%s}}",
+                   step->job, (double)(step->started_ns - start)/1000, (double)step->elapsed_ns/1000, step->ran ? "true" : "false");
+        first = false;
+    }
+    sb_append_cstr(&sb, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    const char *json = graph_report_path(what, "json");
+    write_entire_file(json, sb.items, sb.count);
+    sb_free(sb);
+
+    // the steps on it that did any work, the rest is only up-to-date checks
+    nob_log(NOB_INFO, "%s: critical path %.2fs running, %.2fs waiting for a free job, see %s and %s",
+            what, path_secs, waited_secs, txt, json);
+    for (size_t i = path_len; i > 0; i--) {
+        if (path[i-1]->ran) nob_log(NOB_INFO, "    %7.2fs  %s", (double)path[i-1]->elapsed_ns/NOB_NANOS_PER_SEC, path[i-1]->name);
+    }
+}
+
+// runs every step of `g`, stopping at the first failure once the steps
+// already running have exited; `what` names the build in the timing report
+bool graph_run(Graph *g, const char *what) {
+    if (!mkdir_if_not_exists(LOG_DIR)) return false;
+    size_t jobs = (size_t)nob_nprocs();
+    size_t running = 0, settled = 0, ran = 0;
+    bool failed = false;
+    Cmd cmd = {0};
+    bool *busy = temp_alloc(jobs + 1); // job slots, for the report
+    memset(busy, 0, jobs + 1);
+    uint64_t start = nanos_since_unspecified_epoch();
+    while (running > 0 || (!failed && settled < g->count)) {
+        bool progress = false;
+        for (size_t i = 0; i < g->count && !failed && running < jobs; i++) {
+            Step *step = &g->items[i];
+            if (step->state != STEP_WAITING || !step_ready(g, step)) continue;
+            progress = true;
+            step->started_ns = nanos_since_unspecified_epoch();
+            cmd.count = 0;
+            if (!step->plan(step, &cmd)) {
+                step->state = STEP_FAILED;
+            } else if (cmd.count == 0) {
+                step->state = STEP_DONE;
+            } else if (step_start(g, step, &cmd)) {
+                step->state = STEP_RUNNING;
+                step->ran = true;
+                step->job = 1;
+                while (busy[step->job]) step->job++;
+                busy[step->job] = true;
+                running++;
+                continue;
+            } else {
+                step->state = STEP_FAILED;
+            }
+            step->elapsed_ns = nanos_since_unspecified_epoch() - step->started_ns;
+            settled++;
+            if (step->ran) ran++;
+            if (step->state == STEP_FAILED) {
+                nob_log(NOB_ERROR, "%s failed", step->name);
+                failed = true;
+            }
+        }
+
+        for (size_t i = 0; i < g->count && running > 0; i++) {
+            Step *step = &g->items[i];
+            if (step->state != STEP_RUNNING) continue;
+            int status = nob__proc_wait_async(step->proc, 0);
+            if (status == 0) continue;
+            progress = true;
+            running--;
+            settled++;
+            ran++;
+            busy[step->job] = false;
+            step->elapsed_ns = nanos_since_unspecified_epoch() - step->started_ns;
+            step_print_log(g, step);
+            if (status < 0 || (step->finish && !step->finish(step))) {
+                nob_log(NOB_ERROR, "%s failed", step->name);
+                step->state = STEP_FAILED;
+                failed = true;
+            } else {
+                step->state = STEP_DONE;
+            }
+        }
+
+        if (!progress) {
+            if (running == 0) {
+                nob_log(NOB_ERROR, "%s: %zu steps wait on each other", what, g->count - settled);
+                failed = true;
+                break;
+            }
+            nanosleep(&(struct timespec) { .tv_nsec = 1000*1000 }, NULL);
+        }
+    }
+    cmd_free(cmd);
+
+    double secs = (double)(nanos_since_unspecified_epoch() - start)/NOB_NANOS_PER_SEC;
+    const Step *longest = NULL;
+    for (size_t i = 0; i < g->count; i++) {
+        if (g->items[i].ran && (!longest || g->items[i].elapsed_ns > longest->elapsed_ns)) longest = &g->items[i];
+    }
+    if (longest) {
+        nob_log(failed ? NOB_ERROR : NOB_INFO, "%s: %zu of %zu steps ran in %.2fs, %zu jobs at a time, longest %s (%.2fs)",
+                what, ran, g->count, secs, jobs, longest->name, (double)longest->elapsed_ns/NOB_NANOS_PER_SEC);
+        graph_report(g, what, start, jobs);
+    } else {
+        nob_log(failed ? NOB_ERROR : NOB_INFO, "%s: up to date, checked in %.2fs", what, secs);
+    }
+    return !failed;
+}
+
+/**** Objects ****/
+// An object is two steps: preprocessing for the cache key, which is skipped
+// when the depfile says the object is up to date, then the compile itself,
+// skipped when the cache had it.
+
+typedef struct {
+    const char *out;
+    Cmd compile;        // `-c <src> -o <out>` with depfile_flags()
+    bool fresh;         // up to date, or restored from the cache
+    uint64_t key;       // from cache_preprocess()
+    const char *cached; // from cache_lookup()
+} Object;
+
+bool plan_object_key(Step *step, Cmd *cmd) {
+    Object *obj = step->data;
+    // objects built before RAYLIB_CONFIG existed don't have it in their depfile
+    const char *extra[] = { RAYLIB_CONFIG, PGO_STAMP };
+    obj->fresh = !needs_rebuild_deps(obj->out, extra, pgo != PGO_OFF ? 2 : 1);
+    if (obj->fresh) return true;
+    if (!mkdir_if_not_exists(CACHE_DIR)) return false;
+    obj->key = cache_preprocess(&obj->compile, temp_sprintf("%s.i", obj->out), cmd);
+    return true;
+}
+
+bool finish_object_key(Step *step) {
+    Object *obj = step->data;
+    bool hit;
+    obj->cached = cache_lookup(obj->key, temp_sprintf("%s.i", obj->out), obj->out, &hit);
+    if (hit) {
+        nob_log(NOB_INFO, "Restored %s from "CACHE_DIR, obj->out);
+        obj->fresh = true;
+    }
+    return true;
+}
+
+bool plan_object(Step *step, Cmd *cmd) {
+    Object *obj = step->data;
+    if (obj->fresh) return true;
+    nob_log(NOB_INFO, "Rebuilding %s", obj->out);
+    da_append_many(cmd, obj->compile.items, obj->compile.count);
+    return true;
+}
+
+bool finish_object(Step *step) {
+    Object *obj = step->data;
+    return cache_store(obj->out, obj->cached);
+}
+
+// `compile` is handed over to the graph; returns the step that produces `out`
+size_t graph_object(Graph *g, const char *out, Cmd compile) {
+    Object *obj = temp_alloc(sizeof(*obj));
+    *obj = (Object) { .out = out, .compile = compile };
+    size_t key = graph_step(g, temp_sprintf("%s (cache key)", out), plan_object_key, finish_object_key, obj);
+    size_t step = graph_step(g, out, plan_object, finish_object, obj);
+    graph_dep(g, step, key);
+    return step;
+}
+
+typedef struct {
+    const char *ar;
+    const char *out;
+    File_Paths objs;
+} Archive;
+
+bool plan_archive(Step *step, Cmd *cmd) {
+    Archive *lib = step->data;
+    if (!needs_rebuild(lib->out, lib->objs.items, lib->objs.count)) return true;
+    cmd_append(cmd, lib->ar, "rcs", lib->out);
+    da_append_many(cmd, lib->objs.items, lib->objs.count);
+    return true;
 }
 
 static const char *raylib_sources[] = {
@@ -222,102 +918,208 @@ static const char *raylib_sources[] = {
     "./deps/raylib-6.0/src/raudio.c",
 };
 
-bool build_raylib(Cmd *cmd, Procs *procs, Pipes *pipes) {
-    if (!needs_rebuild("build/lib/libraylib.a", raylib_sources, ARRAY_LEN(raylib_sources))) return true;
-    nob_log(NOB_INFO, "Rebuilding raylib");
-    bool result = true;
-    size_t checkpoint = temp_save();
-    // build objects
-    for (size_t i = 0; i < ARRAY_LEN(raylib_sources); i++) {
-        cc(cmd);
-        cmd_append(cmd, "-c", raylib_sources[i]);
-        cmd_append(cmd, "-o", temp_sprintf("build/%s", objname(raylib_sources[i])));
-        cflags(cmd);
-        includes(cmd);
-        Pipe pipe = {0};
-        if (!pipe_create(&pipe)) return 1;
-        da_append(pipes, pipe);
-        if (!cmd_run(cmd, .async = procs, .stderr_fd = pipe.write)) break;
-    }
-    bool success = procs_flush(procs);
-    flush_pipes(pipes, STDERR_FILENO);
-    if (!success) return_defer(false);
-
-    // link
-    cmd_append(cmd, temp_sprintf("%s/bin/llvm-ar", ndk_toolchain_path));
-    cmd_append(cmd, "rcs");
-    cmd_append(cmd, "build/lib/libraylib.a");
+// `compile` is the compiler and every flag for raylib's objects, which go in
+// `obj_dir`; returns the step that archives them into `lib`
+size_t graph_raylib(Graph *g, const char *obj_dir, const char *lib, const Cmd *compile, const char *ar) {
+    Archive *archive = temp_alloc(sizeof(*archive));
+    *archive = (Archive) { .ar = ar, .out = lib };
+    size_t step = graph_step(g, lib, plan_archive, NULL, archive);
     for (size_t i = 0; i < ARRAY_LEN(raylib_sources); i++) {
-        cmd_append(cmd, temp_sprintf("build/%s", objname(raylib_sources[i])));
+        const char *obj = temp_sprintf("%s/%s", obj_dir, objname(raylib_sources[i]));
+        Cmd cmd = {0};
+        da_append_many(&cmd, compile->items, compile->count);
+        cmd_append(&cmd, "-c", raylib_sources[i]);
+        cmd_append(&cmd, "-o", obj);
+        depfile_flags(&cmd, obj);
+        da_append(&archive->objs, obj);
+        graph_dep(g, step, graph_object(g, obj, cmd));
     }
-    if (!cmd_run(cmd)) return_defer(false);
-defer:
-    temp_rewind(checkpoint);
+    return step;
+}
+
+// With --unity, raylib's modules and main.c compile as one translation unit
+// instead of six raylib objects plus main.o: one compiler run per build
+// instead of seven, and every raylib call the game makes (DrawTextureEx,
+// CheckCollisionPointRec, the raymath helpers) can be inlined at the call site
+// without leaning on LTO. The price is that touching main.c recompiles all of
+// raylib too.
+#define UNITY_SOURCE "build/unity/unity.c"
+
+bool write_raylib_config(void) {
+    String_Builder sb = {0};
+    sb_append_cstr(&sb, "// generated by nob.c from raylib_config[], force-included ahead of raylib's own config.h\n");
+    for (size_t i = 0; i < ARRAY_LEN(raylib_config); i++) {
+        sb_appendf(&sb, "#define %s %s\n", raylib_config[i][0], raylib_config[i][1]);
+    }
+    bool result = mkdir_if_not_exists("build") && write_if_changed(RAYLIB_CONFIG, &sb);
+    sb_free(sb);
     return result;
 }
 
-bool compile_objs(Cmd *cmd, Procs *procs, Pipes *pipes) {
-    bool result = true;
-    size_t checkpoint = temp_save();
-    const char *native_app_glue_src = temp_sprintf("%s/android_native_app_glue.c", native_app_glue_path);
-    // native app glue
-    if (needs_rebuild1("build/android_native_app_glue.o", native_app_glue_src)) {
-        nob_log(NOB_INFO, "Rebuilding android_native_app_glue.o");
-        cc(cmd);
-        cmd_append(cmd, "-c", native_app_glue_src);
-        cmd_append(cmd, "-o", "build/android_native_app_glue.o");
-        cflags(cmd);
-        cmd_append(cmd, temp_sprintf("-I%s", native_app_glue_path));
-        if (!cmd_run(cmd)) return_defer(false);
+bool write_unity_source(void) {
+    String_Builder sb = {0};
+    sb_append_cstr(&sb, "// generated by nob.c for --unity, compiles with -I. from the repo root\n");
+    for (size_t i = 0; i < ARRAY_LEN(raylib_sources); i++) {
+        sb_appendf(&sb, "#include \"%s\"\n", raylib_sources[i]);
+        if (strstr(raylib_sources[i], "/rcore.c")) {
+            // rcore.c wants rlgl's implementation, the modules after it only its declarations
+            sb_append_cstr(&sb, "#undef RLGL_IMPLEMENTATION\n");
+        }
     }
+    sb_append_cstr(&sb, "#include \"main.c\"\n");
 
-    // raylib
-    if (!build_raylib(cmd, procs, pipes)) return_defer(false);
+    bool result = mkdir_if_not_exists("build/unity") && write_if_changed(UNITY_SOURCE, &sb);
+    sb_free(sb);
+    return result;
+}
 
-    // main
-    if (needs_rebuild1("build/main.o", "main.c")) {
-        nob_log(NOB_INFO, "Rebuilding main.o");
-        cc(cmd);
-        cmd_append(cmd, "-c", "main.c");
-        cmd_append(cmd, "-o", "build/main.o");
-        cflags(cmd);
-        includes(cmd);
-        if (!cmd_run(cmd)) return_defer(false);
-    }
+// `compile` is the compiler and every flag for the game and raylib; returns
+// the step that compiles UNITY_SOURCE into `obj`
+size_t graph_unity(Graph *g, const char *obj, const Cmd *compile) {
+    Cmd cmd = {0};
+    da_append_many(&cmd, compile->items, compile->count);
+    cmd_append(&cmd, "-I."); // for main.c and raylib_sources, which are relative to the repo root
+    cmd_append(&cmd, "-c", UNITY_SOURCE);
+    cmd_append(&cmd, "-o", obj);
+    depfile_flags(&cmd, obj);
+    return graph_object(g, obj, cmd);
+}
 
-defer:
-    temp_rewind(checkpoint);
+/**** APK ****/
+
+bool plan_keystore(Step *step, Cmd *cmd) {
+    UNUSED(step);
+    const char *keystore = "build/"APP_NAME".keystore";
+    if (file_exists(keystore)) return true;
+    cmd_append(cmd, java_bin("keytool"));
+    cmd_append(cmd, "-genkeypair");
+    cmd_append(cmd, "-validity", "10000");
+    cmd_append(cmd, "-dname", "CN="APP_AUTHOR",O=Android,C=ES");
+    cmd_append(cmd, "-keystore", keystore);
+    cmd_append(cmd, "-storepass", "foobar");
+    cmd_append(cmd, "-alias", APP_NAME"Key");
+    cmd_append(cmd, "-keyalg", "RSA");
+    return true;
+}
+
+#define SDF_ASSETS_DIR "build/assets-sdf"
+
+// the assets directory that goes into the APK
+const char *apk_assets_dir(void) {
+    return sdf_faces ? SDF_ASSETS_DIR : "./assets";
+}
+
+// resources.apk is linked from apk_assets_dir(), so each kind of faces has its own
+const char *resources_apk(void) {
+    return sdf_faces ? "build/bin/resources-sdf.apk" : "build/bin/resources.apk";
+}
+
+// copies assets/ but for the card PNGs into SDF_ASSETS_DIR, the SDF faces
+// need none of them
+bool stage_sdf_assets(void) {
+    File_Paths files = {0};
+    walk_dir("./assets", collect_regular_files, .data = &files);
+    bool result = mkdir_if_not_exists(SDF_ASSETS_DIR);
+    for (size_t i = 0; i < files.count && result; i++) {
+        const char *rel = files.items[i] + strlen("./assets/");
+        if (strncmp(rel, "playing-cards/", strlen("playing-cards/")) == 0) continue;
+        char *dst = temp_sprintf(SDF_ASSETS_DIR"/%s", rel);
+        for (char *slash = strchr(dst + strlen(SDF_ASSETS_DIR"/"), '/'); slash && result; slash = strchr(slash + 1, '/')) {
+            *slash = '\0';
+            result = mkdir_if_not_exists(dst);
+            *slash = '/';
+        }
+        if (result && needs_rebuild1(dst, files.items[i])) result = copy_file(files.items[i], dst);
+    }
+    da_free(files);
     return result;
 }
 
-bool compile_project_code(Cmd *cmd) {
+// all res and asset files that get bundled into the resources.apk, and the
+// AndroidManifest.xml
+void collect_resource_files(File_Paths *files) {
+    walk_dir("./res", collect_regular_files, .data = files);
+    walk_dir(apk_assets_dir(), collect_regular_files, .data = files);
+    da_append(files, "AndroidManifest.xml");
+}
+
+// `step->data` is one res file
+bool plan_aapt2_compile(Step *step, Cmd *cmd) {
+    cmd_append(cmd, temp_sprintf("%s/aapt2", android_build_tools));
+    cmd_append(cmd, "compile");
+    cmd_append(cmd, (const char *)step->data);
+    cmd_append(cmd, "-o", "build/compiled");
+    return true;
+}
+
+bool plan_aapt2_link(Step *step, Cmd *cmd) {
+    // this step generates a starting APK with resources + R.java for loading
+    // outputs: R.java, resources.apk
+    UNUSED(step);
+    const char *apk_path = resources_apk();
+    File_Paths files = {0};
+    collect_resource_files(&files);
+    bool stale = needs_rebuild(apk_path, files.items, files.count);
+    if (stale) {
+        nob_log(NOB_INFO, "assets files have changed, rebuilding %s", apk_path);
+        // grab the generated *.flat files form the compile step
+        files.count = 0;
+        walk_dir("./build/compiled", collect_regular_files, .data = &files);
+        cmd_append(cmd, temp_sprintf("%s/aapt2", android_build_tools));
+        cmd_append(cmd, "link");
+        cmd_append(cmd, "--min-sdk-version", STR(ANDROID_MIN_SDK));
+        cmd_append(cmd, "--target-sdk-version", STR(ANDROID_TARGET_SDK));
+        cmd_append(cmd, "-o", apk_path);
+        cmd_append(cmd, "--java", "build/gen/");
+        cmd_append(cmd, "-I", temp_sprintf("%s/platforms/android-%d/android.jar", sdk_path, ANDROID_TARGET_SDK));
+        da_append_many(cmd, files.items, files.count);
+        cmd_append(cmd, "--manifest", "AndroidManifest.xml");
+        cmd_append(cmd, "-A", apk_assets_dir());
+        // cmd_append(cmd, "-v");
+    }
+    da_free(files);
+    return true;
+}
+
+// `step->data` is the Abi
+bool plan_project_code(Step *step, Cmd *cmd) {
 	// $(CC) -o $(PROJECT_BUILD_PATH)/lib/$(ANDROID_ARCH_NAME)/lib$(PROJECT_LIBRARY_NAME).so $(OBJS) -shared $(INCLUDE_PATHS) $(LDFLAGS) $(LDLIBS)
-    const char *so_out = "build/lib/arm64-v8a/libmain.so";
-    static const char *so_sources[] = {
-        "build/main.o",
-        "build/android_native_app_glue.o",
-        "build/lib/libraylib.a",
+    const Abi *abi = step->data;
+    const char *so_out = temp_sprintf("%s/lib/%s/libmain.so", profile_dir(), abi->name);
+    // with --unity, raylib is already in unity.o
+    const char *so_sources[] = {
+        temp_sprintf("%s/%s/%s", profile_dir(), abi->name, unity ? "unity.o" : "main.o"),
+        temp_sprintf("%s/%s/android_native_app_glue.o", profile_dir(), abi->name),
+        temp_sprintf("%s/%s/libraylib.a", profile_dir(), abi->name),
     };
-    if (needs_rebuild(so_out, so_sources, ARRAY_LEN(so_sources))) {
-        nob_log(NOB_INFO, "Rebuilding libmain.so");
+    if (needs_rebuild(so_out, so_sources, unity ? 2 : ARRAY_LEN(so_sources))) {
+        nob_log(NOB_INFO, "Rebuilding %s", so_out);
         cc(cmd);
         cmd_append(cmd, "-shared");
         cmd_append(cmd, "-o", so_out);
-        cmd_append(cmd, "build/main.o");
-        cmd_append(cmd, "build/android_native_app_glue.o");
-        target_flags(cmd);
-        ldflags(cmd);
+        cmd_append(cmd, so_sources[0]);
+        cmd_append(cmd, so_sources[1]);
+        target_flags(cmd, abi);
+        ldflags(cmd, abi);
         // libs
         cmd_append(cmd, "-lm", "-lc", "-llog", "-ldl");
-        cmd_append(cmd, "-lraylib");
+        if (!unity) cmd_append(cmd, "-lraylib");
         cmd_append(cmd, "-landroid");
         cmd_append(cmd, "-lEGL", "-lGLESv2", "-lOpenSLES");
-        if (!cmd_run(cmd)) return false;
     }
+    return true;
+}
 
+// the size that goes into the APK is what the profiles are compared on
+bool finish_project_code(Step *step) {
+    const Abi *abi = step->data;
+    const char *so = temp_sprintf("%s/lib/%s/libmain.so", profile_dir(), abi->name);
+    log_size(so);
     return true;
 }
-bool compile_project_class(Cmd *cmd) {
+
+bool plan_project_class(Step *step, Cmd *cmd) {
+    UNUSED(step);
     static const char *java_sources[] = {
         "java/com/"APP_AUTHOR"/"APP_NAME"/NativeLoader.java",
         "build/gen/com/"APP_AUTHOR"/"APP_NAME"/R.java",
@@ -335,7 +1137,6 @@ bool compile_project_class(Cmd *cmd) {
         cmd_append(cmd, "-d", "build/");
         cmd_append(cmd, "-classpath", temp_sprintf("%s/platforms/android-%d/android.jar", sdk_path, ANDROID_TARGET_SDK));
         da_append_many(cmd, java_sources, ARRAY_LEN(java_sources));
-        return cmd_run(cmd);
     }
     return true;
 }
@@ -349,9 +1150,8 @@ bool find_class_files(Walk_Entry entry) {
     return true;
 }
 
-bool compile_project_class_dex(Cmd *cmd) {
-    bool result = true;
-    size_t checkpoint = temp_save();
+bool plan_project_class_dex(Step *step, Cmd *cmd) {
+    UNUSED(step);
     File_Paths class_files = {0};
     walk_dir("build/com", find_class_files, .data = &class_files);
     if (needs_rebuild("./build/bin/classes.dex", class_files.items, class_files.count)) {
@@ -363,75 +1163,305 @@ bool compile_project_class_dex(Cmd *cmd) {
         for (size_t i = 0; i < class_files.count; i++) {
             cmd_append(cmd, class_files.items[i]);
         }
-        if (!cmd_run(cmd)) return_defer(false);
     }
-defer:
-    temp_rewind(checkpoint);
     da_free(class_files);
-    return result;
+    return true;
+}
+
+/**** APK packaging ****/
+// The unsigned APK is resources.apk's entries followed by classes.dex and
+// every libmain.so, written here rather than by zip + zipalign. Stored
+// entries come out aligned the way zipalign -P 16 4 would have left them:
+// 16K for the libraries, so they can be mmap'd straight from the APK, and 4
+// for the rest (resources.arsc has to be). The entries that change between
+// builds go last, so a rebuild keeps everything up to the first entry that
+// changed where it is in the file and only rewrites from there on, which
+// for a native-only change is just the libraries.
+// Nothing is compressed: entries from resources.apk are copied as aapt2
+// wrote them, and classes.dex is stored, which the runtime can use in
+// place.
+
+#define ZIP_LOCAL_HEADER   0x04034b50
+#define ZIP_CENTRAL_HEADER 0x02014b50
+#define ZIP_END            0x06054b50
+#define ZIP_ALIGN_EXTRA    0xd935 // zipalign's extra field, a 2 byte alignment then padding
+#define ZIP_COMMENT        "nob.c" // marks archives whose layout zip_write_apk() can reuse
+
+typedef struct {
+    const char *name;
+    uint16_t flags, method, time, date;
+    uint32_t crc, csize, usize;
+    uint32_t offset;      // of the local header
+    uint32_t base_offset; // of the local header in resources.apk, for entries copied from there
+    const char *data;     // for entries read from a file
+} Zip_Entry;
+
+typedef struct {
+    Zip_Entry *items;
+    size_t count;
+    size_t capacity;
+} Zip_Entries;
+
+uint32_t crc32(const void *data, size_t size) {
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+    uint32_t crc = 0xffffffff;
+    const uint8_t *p = data;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffff;
 }
 
-bool create_project_apk_package(Cmd *cmd) {
-	// $(ANDROID_BUILD_TOOLS)/aapt package -f -M $(PROJECT_BUILD_PATH)/AndroidManifest.xml -S $(PROJECT_BUILD_PATH)/res -A $(PROJECT_BUILD_PATH)/assets -I $(ANDROID_HOME)/platforms/android-$(ANDROID_API_VERSION)/android.jar -F $(PROJECT_BUILD_PATH)/bin/$(PROJECT_NAME).unsigned.apk $(PROJECT_BUILD_PATH)/bin
-	// cd $(PROJECT_BUILD_PATH) && $(ANDROID_BUILD_TOOLS)/aapt add bin/$(PROJECT_NAME).unsigned.apk lib/$(ANDROID_ARCH_NAME)/lib$(PROJECT_LIBRARY_NAME).so $(PROJECT_SHARED_LIBS)
+// reads the central directory of the archive at `path`; `comment`, if not
+// NULL, is set to whether the archive carries ZIP_COMMENT
+bool zip_read_entries(const char *path, Zip_Entries *entries, bool *comment) {
     bool result = true;
-    size_t checkpoint = temp_save();
-    const char *pwd_save = get_current_dir_temp();
-    const char *apk_out = APP_NAME".unsigned.apk";
-    set_current_dir("build");
-    const char *sources[] = {
-        "bin/resources.apk",
-        "bin/classes.dex",
-        "lib/arm64-v8a/libmain.so",
-    };
-    if (needs_rebuild(apk_out, sources, ARRAY_LEN(sources))) {
-        // copy over the resources.apk as a starting point
-        if (!copy_file("bin/resources.apk", APP_NAME".unsigned.apk")) return false;
-        // throw in the dex file
-        cmd_append(cmd, "zip");
-        cmd_append(cmd, "-j");                            // junk paths (add to root of zip)
-        cmd_append(cmd, APP_NAME".unsigned.apk"); // zip archive
-        cmd_append(cmd, "bin/classes.dex");         // file to add
-        if (!cmd_run(cmd)) return_defer(false);
-        // add app shared library
-        cmd_append(cmd, "zip");
-        cmd_append(cmd, "-0"); // don't deflate: required for .so so it can be mmap'd
-        cmd_append(cmd, APP_NAME".unsigned.apk");
-        cmd_append(cmd, "lib/arm64-v8a/libmain.so");
-        if (!cmd_run(cmd)) return_defer(false);
+    String_Builder tail = {0};
+    String_Builder dir = {0};
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    // the end record is the last 22 bytes, plus a comment of up to 64K
+    if (fseek(f, 0, SEEK_END) != 0) return_defer(false);
+    long size = ftell(f);
+    long tail_size = size < 22 + 0xffff ? size : 22 + 0xffff;
+    da_reserve(&tail, (size_t)tail_size);
+    if (fseek(f, size - tail_size, SEEK_SET) != 0 || fread(tail.items, 1, tail_size, f) != (size_t)tail_size) return_defer(false);
+    const uint8_t *end = NULL;
+    for (long i = tail_size - 22; i >= 0 && !end; i--) {
+        const uint8_t *p = (const uint8_t *)tail.items + i;
+        if (get_le(p, 4) == ZIP_END && i + 22 + (long)get_le(p + 20, 2) == tail_size) end = p;
+    }
+    if (!end) return_defer(false);
+    size_t count = get_le(end + 10, 2);
+    uint32_t dir_size = get_le(end + 12, 4);
+    uint32_t dir_offset = get_le(end + 16, 4);
+    if (comment) *comment = get_le(end + 20, 2) == strlen(ZIP_COMMENT) && memcmp(end + 22, ZIP_COMMENT, strlen(ZIP_COMMENT)) == 0;
+    da_reserve(&dir, dir_size);
+    if (fseek(f, dir_offset, SEEK_SET) != 0 || fread(dir.items, 1, dir_size, f) != dir_size) return_defer(false);
+    const uint8_t *p = (const uint8_t *)dir.items;
+    for (size_t i = 0; i < count; i++) {
+        if (p + 46 > (const uint8_t *)dir.items + dir_size || get_le(p, 4) != ZIP_CENTRAL_HEADER) return_defer(false);
+        size_t name_len = get_le(p + 28, 2);
+        da_append(entries, ((Zip_Entry) {
+            .name = temp_strndup((const char *)p + 46, name_len),
+            .flags = get_le(p + 8, 2),
+            .method = get_le(p + 10, 2),
+            .time = get_le(p + 12, 2),
+            .date = get_le(p + 14, 2),
+            .crc = get_le(p + 16, 4),
+            .csize = get_le(p + 20, 4),
+            .usize = get_le(p + 24, 4),
+            .offset = get_le(p + 42, 4),
+        }));
+        p += 46 + name_len + get_le(p + 30, 2) + get_le(p + 32, 2);
     }
 defer:
-    set_current_dir(pwd_save);
-    temp_rewind(checkpoint);
+    fclose(f);
+    sb_free(tail);
+    sb_free(dir);
     return result;
 }
 
-bool zipalign_project_apk_package(Cmd *cmd) {
-    size_t checkpoint = temp_save();
+// 16K for the libraries, 4 for anything else stored
+size_t zip_alignment(const Zip_Entry *e) {
+    return sv_ends_with_cstr(sv_from_cstr(e->name), ".so") ? 16384 : 4;
+}
+
+bool zip_same_entry(const Zip_Entry *a, const Zip_Entry *b) {
+    return strcmp(a->name, b->name) == 0 && a->method == b->method && a->crc == b->crc &&
+        a->csize == b->csize && a->usize == b->usize;
+}
+
+// Writes `entries` to `out` as an archive, keeping the part of an existing
+// `out` up to the first entry that differs. Entries without `data` are copied
+// raw from `base`. Returns the bytes written, 0 if `out` was already up to date.
+long zip_write_apk(const char *out, const char *base, Zip_Entries *entries) {
+    long written = -1;
+    Zip_Entries old = {0};
+    bool ours = false;
+    size_t kept = 0;
+    if (zip_read_entries(out, &old, &ours) && ours) {
+        while (kept < old.count && kept < entries->count && zip_same_entry(&old.items[kept], &entries->items[kept])) {
+            entries->items[kept].offset = old.items[kept].offset;
+            kept++;
+        }
+        if (kept == entries->count && kept == old.count) {
+            da_free(old);
+            return 0;
+        }
+    }
+    FILE *src = NULL;
+    FILE *f = kept ? fopen(out, "r+b") : fopen(out, "wb");
+    String_Builder sb = {0};
+    if (!f) goto defer;
+    src = fopen(base, "rb");
+    if (!src) goto defer;
+    // where the kept part ends: the first entry that changed, or where the central directory was
+    long start = 0;
+    if (kept) {
+        const Zip_Entry *last = &old.items[kept - 1];
+        uint8_t header[30];
+        if (fseek(f, last->offset, SEEK_SET) != 0 || fread(header, 1, sizeof header, f) != sizeof header) goto defer;
+        start = last->offset + 30 + get_le(header + 26, 2) + get_le(header + 28, 2) + last->csize;
+    }
+    if (fseek(f, start, SEEK_SET) != 0) goto defer;
+    long at = start;
+    for (size_t i = kept; i < entries->count; i++) {
+        Zip_Entry *e = &entries->items[i];
+        e->offset = (uint32_t)at;
+        e->flags &= ~0x0008; // sizes go in the local header, no data descriptor after the data
+        size_t name_len = strlen(e->name);
+        size_t extra_len = 0;
+        if (e->method == 0) {
+            extra_len = 6;
+            while ((at + 30 + name_len + extra_len) % zip_alignment(e)) extra_len++;
+        }
+        sb.count = 0;
+        put_le(&sb, ZIP_LOCAL_HEADER, 4);
+        put_le(&sb, e->method ? 20 : 10, 2); // version needed to extract
+        put_le(&sb, e->flags, 2);
+        put_le(&sb, e->method, 2);
+        put_le(&sb, e->time, 2);
+        put_le(&sb, e->date, 2);
+        put_le(&sb, e->crc, 4);
+        put_le(&sb, e->csize, 4);
+        put_le(&sb, e->usize, 4);
+        put_le(&sb, name_len, 2);
+        put_le(&sb, extra_len, 2);
+        sb_append_buf(&sb, e->name, name_len);
+        if (extra_len) {
+            put_le(&sb, ZIP_ALIGN_EXTRA, 2);
+            put_le(&sb, extra_len - 4, 2);
+            put_le(&sb, zip_alignment(e), 2);
+            for (size_t k = 6; k < extra_len; k++) da_append(&sb, 0);
+        }
+        if (fwrite(sb.items, 1, sb.count, f) != sb.count) goto defer;
+        at += sb.count;
+        if (e->data) {
+            if (fwrite(e->data, 1, e->csize, f) != e->csize) goto defer;
+        } else {
+            // straight from resources.apk, compressed or not
+            uint8_t header[30];
+            if (fseek(src, e->base_offset, SEEK_SET) != 0 || fread(header, 1, sizeof header, src) != sizeof header) goto defer;
+            if (fseek(src, get_le(header + 26, 2) + get_le(header + 28, 2), SEEK_CUR) != 0) goto defer;
+            char buf[64*1024];
+            for (uint32_t left = e->csize; left > 0;) {
+                size_t n = left < sizeof buf ? left : sizeof buf;
+                if (fread(buf, 1, n, src) != n || fwrite(buf, 1, n, f) != n) goto defer;
+                left -= n;
+            }
+        }
+        at += e->csize;
+    }
+    sb.count = 0;
+    for (size_t i = 0; i < entries->count; i++) {
+        const Zip_Entry *e = &entries->items[i];
+        size_t name_len = strlen(e->name);
+        put_le(&sb, ZIP_CENTRAL_HEADER, 4);
+        put_le(&sb, 20, 2); // made by
+        put_le(&sb, e->method ? 20 : 10, 2);
+        put_le(&sb, e->flags, 2);
+        put_le(&sb, e->method, 2);
+        put_le(&sb, e->time, 2);
+        put_le(&sb, e->date, 2);
+        put_le(&sb, e->crc, 4);
+        put_le(&sb, e->csize, 4);
+        put_le(&sb, e->usize, 4);
+        put_le(&sb, name_len, 2);
+        put_le(&sb, 0, 2); // extra
+        put_le(&sb, 0, 2); // comment
+        put_le(&sb, 0, 2); // disk
+        put_le(&sb, 0, 2); // internal attributes
+        put_le(&sb, 0, 4); // external attributes
+        put_le(&sb, e->offset, 4);
+        sb_append_buf(&sb, e->name, name_len);
+    }
+    size_t dir_size = sb.count;
+    put_le(&sb, ZIP_END, 4);
+    put_le(&sb, 0, 2);
+    put_le(&sb, 0, 2);
+    put_le(&sb, entries->count, 2);
+    put_le(&sb, entries->count, 2);
+    put_le(&sb, dir_size, 4);
+    put_le(&sb, at, 4);
+    put_le(&sb, strlen(ZIP_COMMENT), 2);
+    sb_append_cstr(&sb, ZIP_COMMENT);
+    if (fwrite(sb.items, 1, sb.count, f) != sb.count) goto defer;
+    at += sb.count;
+    if (fflush(f) != 0 || ftruncate(fileno(f), at) != 0) goto defer;
+    written = at - start;
+    nob_log(NOB_INFO, "%s: kept %zu of %zu entries, wrote %ld KiB", out, kept, entries->count, written/1024);
+defer:
+    if (written < 0) nob_log(NOB_ERROR, "Could not write %s: %s", out, strerror(errno));
+    if (f && fclose(f) != 0) written = -1;
+    if (src) fclose(src);
+    sb_free(sb);
+    da_free(old);
+    return written;
+}
+
+// `step->data` is the Abi_List being built; runs in-process, so it does its
+// work here rather than handing the graph a command
+bool plan_project_apk_package(Step *step, Cmd *cmd) {
+    UNUSED(cmd);
+    const Abi_List *targets = step->data;
+    const char *base = resources_apk();
+    const char *apk_out = temp_sprintf("%s/"APP_NAME".unsigned.apk", profile_dir());
+    File_Paths sources = {0};
+    da_append(&sources, base);
+    da_append(&sources, "build/bin/classes.dex");
+    for (size_t i = 0; i < targets->count; i++) {
+        da_append(&sources, temp_sprintf("%s/lib/%s/libmain.so", profile_dir(), targets->items[i]->name));
+    }
     bool result = true;
-    const char *apk_in  = "build/"APP_NAME".unsigned.apk";
-    const char *apk_out = "build/"APP_NAME".aligned.apk";
-    if (needs_rebuild1(apk_out, apk_in)) {
-        cmd_append(cmd, temp_sprintf("%s/zipalign", android_build_tools));
-        cmd_append(cmd, "-P", "16");  // enforce 16K alignment for .so files
-        cmd_append(cmd, "-f");        // force overwrite existing output file
-        cmd_append(cmd, "-v");        // verbose output
-        cmd_append(cmd, "4");         // 4 byte alignment for regular entries
-        cmd_append(cmd, apk_in);
-        cmd_append(cmd, apk_out);
-        if (!cmd_run(cmd)) return_defer(false);
+    Zip_Entries entries = {0};
+    if (!needs_rebuild(apk_out, sources.items, sources.count)) return_defer(true);
+    if (!zip_read_entries(base, &entries, NULL)) {
+        nob_log(NOB_ERROR, "Could not read %s", base);
+        return_defer(false);
+    }
+    for (size_t i = 0; i < entries.count; i++) entries.items[i].base_offset = entries.items[i].offset;
+    for (size_t i = 1; i < sources.count; i++) {
+        String_Builder sb = {0};
+        if (!read_entire_file(sources.items[i], &sb)) return_defer(false);
+        const char *name = i == 1 ? "classes.dex" : temp_sprintf("lib/%s/libmain.so", targets->items[i - 2]->name);
+        da_append(&entries, ((Zip_Entry) {
+            .name = name,
+            .date = (1 << 5) | 1, // 1980-01-01, so the same file makes the same entry
+            .crc = crc32(sb.items, sb.count),
+            .csize = (uint32_t)sb.count,
+            .usize = (uint32_t)sb.count,
+            .data = sb.items,
+        }));
+    }
+    long written = zip_write_apk(apk_out, base, &entries);
+    if (written < 0) return_defer(false);
+    // 0 if everything was relinked to the same bytes, and the signed APK is still
+    // good; bump both so the next build doesn't read and CRC every input again
+    step->ran = written > 0;
+    if (written == 0) {
+        const char *signed_apk = temp_sprintf("%s/"APP_NAME".apk", profile_dir());
+        bool signed_ok = !needs_rebuild1(signed_apk, apk_out);
+        if (utime(apk_out, NULL) != 0) nob_log(NOB_WARNING, "Could not update the time of %s", apk_out);
+        if (signed_ok && utime(signed_apk, NULL) != 0) nob_log(NOB_WARNING, "Could not update the time of %s", signed_apk);
     }
 defer:
-    temp_rewind(checkpoint);
+    for (size_t i = 0; i < entries.count; i++) free((void *)entries.items[i].data);
+    da_free(entries);
+    da_free(sources);
     return result;
 }
 
-bool sign_project_apk_package(Cmd *cmd) {
+bool plan_sign_project_apk_package(Step *step, Cmd *cmd) {
+    UNUSED(step);
     const char *keystore = "build/"APP_NAME".keystore";
-    const char *apk_in = "build/"APP_NAME".aligned.apk";
-    const char *apk_out = "build/"APP_NAME".apk";
-    bool result = true;
-    size_t checkpoint = temp_save();
+    const char *apk_in = temp_sprintf("%s/"APP_NAME".unsigned.apk", profile_dir()); // already aligned
+    const char *apk_out = temp_sprintf("%s/"APP_NAME".apk", profile_dir());
     if (needs_rebuild1(apk_out, apk_in)) {
         cmd_append(cmd, temp_sprintf("%s/apksigner", android_build_tools));
         cmd_append(cmd, "-J-enable-native-access=ALL-UNNAMED"); // be rid of pesky warning message
@@ -441,30 +1471,303 @@ bool sign_project_apk_package(Cmd *cmd) {
         cmd_append(cmd, "--verbose");
         cmd_append(cmd, "--ks", keystore);
         cmd_append(cmd, "--ks-pass", "pass:foobar");
-        if (!cmd_run(cmd)) return_defer(false);
     }
-defer:
+    return true;
+}
+
+// what --faces sdf saves shows here
+bool finish_sign_project_apk_package(Step *step) {
+    UNUSED(step);
+    log_size(temp_sprintf("%s/"APP_NAME".apk", profile_dir()));
+    return true;
+}
+
+void graph_apk(Graph *g, const Abi_List *targets) {
+    size_t keystore = graph_step(g, "keystore", plan_keystore, NULL, NULL);
+
+    // resources: every res file compiles on its own, then they're linked
+    size_t resources = graph_step(g, "resources.apk", plan_aapt2_link, NULL, NULL);
+    File_Paths files = {0};
+    collect_resource_files(&files);
+    if (needs_rebuild(resources_apk(), files.items, files.count)) {
+        files.count = 0;
+        walk_dir("./res", collect_regular_files, .data = &files);
+        for (size_t i = 0; i < files.count; i++) {
+            graph_dep(g, resources, graph_step(g, files.items[i], plan_aapt2_compile, NULL, (void *)files.items[i]));
+        }
+    }
+    da_free(files);
+
+    // Java, which needs the R.java from linking the resources
+    size_t classes = graph_step(g, "classes", plan_project_class, NULL, NULL);
+    graph_dep(g, classes, resources);
+    size_t dex = graph_step(g, "classes.dex", plan_project_class_dex, NULL, NULL);
+    graph_dep(g, dex, classes);
+
+    size_t package = graph_step(g, APP_NAME".unsigned.apk", plan_project_apk_package, NULL, (void *)targets);
+    graph_dep(g, package, resources);
+    graph_dep(g, package, dex);
+
+    // native code, every ABI side by side
+    for (size_t i = 0; i < targets->count; i++) {
+        const Abi *abi = targets->items[i];
+        const char *dir = temp_sprintf("%s/%s", profile_dir(), abi->name);
+
+        Cmd compile = {0};
+        const char *native_app_glue_src = temp_sprintf("%s/android_native_app_glue.c", native_app_glue_path);
+        const char *glue_o = temp_sprintf("%s/android_native_app_glue.o", dir);
+        cc(&compile);
+        cmd_append(&compile, "-c", native_app_glue_src);
+        cmd_append(&compile, "-o", glue_o);
+        depfile_flags(&compile, glue_o);
+        cflags(&compile, abi);
+        cmd_append(&compile, temp_sprintf("-I%s", native_app_glue_path));
+        size_t glue = graph_object(g, glue_o, compile);
+
+        size_t so = graph_step(g, temp_sprintf("lib/%s/libmain.so", abi->name), plan_project_code, finish_project_code, (void *)abi);
+        graph_dep(g, so, glue);
+        graph_dep(g, package, so);
+
+        if (unity) {
+            compile = (Cmd) {0};
+            cc(&compile);
+            cflags(&compile, abi);
+            includes(&compile);
+            graph_dep(g, so, graph_unity(g, temp_sprintf("%s/unity.o", dir), &compile));
+            cmd_free(compile);
+            continue;
+        }
+
+        Cmd raylib_compile = {0};
+        cc(&raylib_compile);
+        cflags(&raylib_compile, abi);
+        includes(&raylib_compile);
+        size_t raylib = graph_raylib(g, dir, temp_sprintf("%s/libraylib.a", dir), &raylib_compile, temp_sprintf("%s/bin/llvm-ar", ndk_toolchain_path));
+        cmd_free(raylib_compile);
+
+        const char *main_o = temp_sprintf("%s/main.o", dir);
+        compile = (Cmd) {0};
+        cc(&compile);
+        cmd_append(&compile, "-c", "main.c");
+        cmd_append(&compile, "-o", main_o);
+        depfile_flags(&compile, main_o);
+        cflags(&compile, abi);
+        includes(&compile);
+        graph_dep(g, so, graph_object(g, main_o, compile));
+        graph_dep(g, so, raylib);
+    }
+
+    size_t sign = graph_step(g, APP_NAME".apk", plan_sign_project_apk_package, finish_sign_project_apk_package, NULL);
+    graph_dep(g, sign, package);
+    graph_dep(g, sign, keystore);
+}
+
+/**** Host (headless) build ****/
+// raylib's PLATFORM_MEMORY backend draws with the rlsw software renderer into a
+// memory framebuffer, so the game runs on the build machine without a device or GPU
+
+void host_cflags(Cmd *cmd) {
+    cmd_append(cmd, "-Wall");
+    cmd_append(cmd, "-std=c99");
+    cmd_append(cmd, "-D_GNU_SOURCE");
+    cmd_append(cmd, "-DPLATFORM_MEMORY");
+    cmd_append(cmd, "-DGRAPHICS_API_OPENGL_SOFTWARE");
+    cmd_append(cmd, "-DSUPPORT_CUSTOM_FRAME_CONTROL=1");
+    cmd_append(cmd, "-I./deps/raylib-6.0/src");
+    cmd_append(cmd, "-I."); // rlsw.h re-includes itself through __FILE__, which is relative to here
+    cmd_append(cmd, "-include", RAYLIB_CONFIG);
+    profile_flags(cmd, "-flto");
+}
+
+// with --unity, the whole of UNITY_SOURCE goes straight into the executable
+bool plan_host_exe(Step *step, Cmd *cmd) {
+    UNUSED(step);
+    const char *exe = temp_sprintf("%s/solitaire", host_dir());
+    const char *libs[] = { unity ? UNITY_SOURCE : temp_sprintf("%s/libraylib.a", host_dir()), RAYLIB_CONFIG, PGO_STAMP };
+    if (needs_rebuild_deps(exe, libs, pgo != PGO_OFF ? 3 : 2)) {
+        nob_log(NOB_INFO, "Rebuilding %s", exe);
+        nob_cc(cmd);
+        cmd_append(cmd, "-o", exe);
+        depfile_flags(cmd, exe);
+        if (unity) {
+            cmd_append(cmd, UNITY_SOURCE);
+            host_cflags(cmd);
+            cmd_append(cmd, "-w"); // raylib's half of it, see build_host()
+        } else {
+            cmd_append(cmd, "main.c");
+            host_cflags(cmd);
+            cmd_append(cmd, temp_sprintf("-L./%s", host_dir()), "-lraylib");
+        }
+        profile_ldflags(cmd);
+        cmd_append(cmd, "-DASSETS_DIR=\"assets/\"");
+        cmd_append(cmd, "-lm", "-lpthread", "-ldl");
+    }
+    return true;
+}
+
+bool finish_host_exe(Step *step) {
+    UNUSED(step);
+    log_size(temp_sprintf("%s/solitaire", host_dir()));
+    return true;
+}
+
+bool build_host(void) {
+    if (!mkdir_if_not_exists("build")) return false;
+    if (!mkdir_if_not_exists("build/host")) return false;
+    if (!mkdir_if_not_exists(host_dir())) return false;
+    if (!write_raylib_config()) return false;
+    if (unity && !write_unity_source()) return false;
+    size_t checkpoint = temp_save();
+    Graph g = {0};
+    size_t exe = graph_step(&g, temp_sprintf("%s/solitaire", host_dir()), plan_host_exe, finish_host_exe, NULL);
+    if (!unity) {
+        Cmd raylib_compile = {0};
+        nob_cc(&raylib_compile);
+        host_cflags(&raylib_compile);
+        cmd_append(&raylib_compile, "-w"); // rlsw and friends are noisy under gcc, not our code
+        graph_dep(&g, exe, graph_raylib(&g, host_dir(), temp_sprintf("%s/libraylib.a", host_dir()), &raylib_compile, "ar"));
+        cmd_free(raylib_compile);
+    }
+    bool result = graph_run(&g, temp_sprintf("host %s build", profile->name));
+    graph_free(&g);
     temp_rewind(checkpoint);
     return result;
 }
 
-bool build_apk(Cmd *cmd, Procs *procs, Pipes *pipes) {
-    if (!create_temp_project_dirs()) return false;
+// `faces` is main.c's --faces, each run leaves its frame times in
+// bench_frames.csv and its last frame in bench_<faces>.png, next to the binary
+bool run_bench(Cmd *cmd, const char *faces) {
+    cmd_append(cmd, temp_sprintf("./%s/solitaire", host_dir()));
+    cmd_append(cmd, "--faces", faces);
+    cmd_append(cmd, "--seed", BENCH_SEED);
+    cmd_append(cmd, "--bench", BENCH_SESSION);
+    cmd_append(cmd, "--max-frame-ms", BENCH_MAX_FRAME_MS);
+    cmd_append(cmd, "--max-draw-calls", BENCH_MAX_DRAW_CALLS);
+    cmd_append(cmd, "--csv", temp_sprintf("%s/bench_frames.csv", host_dir()));
+    cmd_append(cmd, "--trace", temp_sprintf("%s/bench_trace.json", host_dir()));
+    cmd_append(cmd, "--screenshot", temp_sprintf("%s/bench_%s.png", host_dir(), faces));
+    return cmd_run(cmd);
+}
+
+
+// p50 and p95 of the frame time (update+render+swap) in a --csv from main.c
+bool bench_frame_times(const char *csv, float *p50, float *p95) {
+    String_Builder sb = {0};
+    if (!read_entire_file(csv, &sb)) return false;
+    da_append(&sb, '\0');
+    struct { float *items; size_t count, capacity; } frames = {0};
+    const char *line = strchr(sb.items, '\n'); // header
+    while (line && *++line) {
+        float update, render, swap;
+        if (sscanf(line, "%f,%f,%f", &update, &render, &swap) == 3) da_append(&frames, update + render + swap);
+        line = strchr(line, '\n');
+    }
+    bool ok = frames.count > 0;
+    if (ok) {
+        qsort(frames.items, frames.count, sizeof(*frames.items), prof_cmp_float);
+        *p50 = prof_percentile(frames.items, frames.count, 50);
+        *p95 = prof_percentile(frames.items, frames.count, 95);
+    }
+    da_free(frames);
+    da_free(sb);
+    return ok;
+}
+
+// builds and benchmarks the host binary in every profile, then sets their
+// sizes and frame times side by side; a profile over the bench limits is
+// still reported
+bool bench_profiles(Cmd *cmd) {
+    const Profile *selected = profile;
+    struct { long size; float p50, p95; bool ran; } results[ARRAY_LEN(profiles)] = {0};
+    for (size_t i = 0; i < ARRAY_LEN(profiles); i++) {
+        profile = &profiles[i];
+        if (!build_host()) return false;
+        run_bench(cmd, "bitmap");
+        results[i].size = file_size(temp_sprintf("%s/solitaire", host_dir()));
+        results[i].ran = bench_frame_times(temp_sprintf("%s/bench_frames.csv", host_dir()), &results[i].p50, &results[i].p95);
+    }
+    profile = selected;
+    nob_log(NOB_INFO, "%-16s %10s %10s %10s", "profile", "size KiB", "p50 ms", "p95 ms");
+    for (size_t i = 0; i < ARRAY_LEN(profiles); i++) {
+        if (results[i].ran) {
+            nob_log(NOB_INFO, "%-16s %10ld %10.2f %10.2f", profiles[i].name, results[i].size/1024, results[i].p50, results[i].p95);
+        } else {
+            nob_log(NOB_INFO, "%-16s %10ld %10s %10s", profiles[i].name, results[i].size/1024, "-", "-");
+        }
+    }
+    return true;
+}
+
+// the rules only need raylib's types, so this doesn't link raylib at all
+bool build_bench_rules(Cmd *cmd) {
+    if (!mkdir_if_not_exists("build")) return false;
+    if (!mkdir_if_not_exists("build/host")) return false;
+    const char *exe = "build/host/bench_rules";
+    if (needs_rebuild_deps(exe, NULL, 0)) {
+        nob_log(NOB_INFO, "Rebuilding %s", exe);
+        nob_cc(cmd);
+        cmd_append(cmd, "-o", exe);
+        depfile_flags(cmd, exe);
+        cmd_append(cmd, "bench/rules.c");
+        cmd_append(cmd, "-Wall", "-std=c99", "-O2", "-D_GNU_SOURCE");
+        cmd_append(cmd, "-march=native"); // lets solitaire_batch.h pick AVX2 where the machine has it
+        cmd_append(cmd, "-I./deps/raylib-6.0/src", "-I.");
+        if (!cmd_run(cmd)) return false;
+    }
+    return true;
+}
+
+bool build_test_stats(Cmd *cmd) {
+    if (!mkdir_if_not_exists("build")) return false;
+    if (!mkdir_if_not_exists("build/host")) return false;
+    const char *exe = "build/host/test_stats";
+    if (needs_rebuild_deps(exe, NULL, 0)) {
+        nob_log(NOB_INFO, "Rebuilding %s", exe);
+        nob_cc(cmd);
+        cmd_append(cmd, "-o", exe);
+        depfile_flags(cmd, exe);
+        cmd_append(cmd, "tests/stats.c");
+        cmd_append(cmd, "-Wall", "-std=c99", "-O2", "-D_GNU_SOURCE");
+        cmd_append(cmd, "-I.");
+        if (!cmd_run(cmd)) return false;
+    }
+    return true;
+}
+
+bool build_sim(Cmd *cmd) {
+    if (!mkdir_if_not_exists("build")) return false;
+    if (!mkdir_if_not_exists("build/host")) return false;
+    const char *exe = "build/host/sim";
+    if (needs_rebuild_deps(exe, NULL, 0)) {
+        nob_log(NOB_INFO, "Rebuilding %s", exe);
+        nob_cc(cmd);
+        cmd_append(cmd, "-o", exe);
+        depfile_flags(cmd, exe);
+        cmd_append(cmd, "tools/sim.c");
+        cmd_append(cmd, "-Wall", "-std=c99", "-O2", "-D_GNU_SOURCE");
+        cmd_append(cmd, "-I./deps/raylib-6.0/src", "-I.");
+        cmd_append(cmd, "-lm", "-lpthread");
+        if (!cmd_run(cmd)) return false;
+    }
+    return true;
+}
+
+bool build_apk(const Abi_List *targets) {
+    if (!create_temp_project_dirs(targets)) return false;
+    if (!write_raylib_config()) return false;
+    if (unity && !write_unity_source()) return false;
+    if (sdf_faces && !stage_sdf_assets()) return false;
     // In Makefile.Android, this generated NativeLoader.java
     // if (!generate_loader_script()) return false;
     // In Makefile.Android, this generated the AndroidManifest.xml
     // if (!generate_android_manifest()) return false;
-    if (!generate_apk_keystore(cmd)) return false;
-    if (!config_project_package(cmd, procs)) return false;
-    if (!compile_objs(cmd, procs, pipes)) return false;
-    if (!compile_project_code(cmd)) return false;
-    if (!compile_project_class(cmd)) return false;
-    if (!compile_project_class_dex(cmd)) return false;
-    if (!create_project_apk_package(cmd)) return false;
-    if (!zipalign_project_apk_package(cmd)) return false;
-    if (!sign_project_apk_package(cmd)) return false;
-
-    return true;
+    size_t checkpoint = temp_save();
+    Graph g = {0};
+    graph_apk(&g, targets);
+    bool result = graph_run(&g, "APK build");
+    graph_free(&g);
+    temp_rewind(checkpoint);
+    return result;
 }
 
 bool setup_paths() {
@@ -522,6 +1825,137 @@ bool setup_paths() {
     return true;
 }
 
+/**** Profile-guided optimization ****/
+// `./nob pgo` builds the host binary instrumented, replays BENCH_SESSION on
+// it and rebuilds with what it recorded, benchmarking the plain build and
+// the optimized one on the same replay. With clang the profiles are merged
+// by llvm-profdata, the NDK's if there is one, and the APK is then rebuilt
+// under build/<profile>-pgo/ with the same profile. The replay runs the
+// PLATFORM_MEMORY build, so libmain.so's platform code goes unprofiled; the
+// game and the drawing, where the frame time goes, are the same code either
+// way. gcc's profiles are only good for gcc, so without clang it stops after
+// the host binary.
+
+bool host_cc_is_clang(void) {
+    Cmd cmd = {0};
+    nob_cc(&cmd);
+    cmd_append(&cmd, "--version");
+    String_Builder sb = {0};
+    const char *out = PGO_DIR"/cc-version";
+    bool clang = cmd_run(&cmd, .stdout_path = out) && read_entire_file(out, &sb);
+    if (clang) {
+        da_append(&sb, '\0');
+        clang = strstr(sb.items, "clang") != NULL;
+    }
+    da_free(sb);
+    cmd_free(cmd);
+    return clang;
+}
+
+bool collect_profiles(Walk_Entry entry) {
+    File_Paths *files = entry.data;
+    String_View path = sv_from_cstr(entry.path);
+    if (entry.type == FILE_REGULAR && (sv_ends_with(path, sv_from_cstr(".profraw")) || sv_ends_with(path, sv_from_cstr(".gcda")))) {
+        da_append(files, temp_strdup(entry.path));
+    }
+    return true;
+}
+
+// both compilers add to profiles already there, so every training run starts from none
+bool pgo_clear(void) {
+    File_Paths files = {0};
+    bool ok = walk_dir(PGO_RAW_DIR, collect_profiles, .data = &files);
+    for (size_t i = 0; ok && i < files.count; i++) ok = delete_file(files.items[i]);
+    da_free(files);
+    return ok;
+}
+
+bool pgo_stage(Pgo_Stage stage) {
+    pgo = stage;
+    return write_entire_file(PGO_STAMP, "", 0);
+}
+
+// the `what` build's frame times from its last run_bench()
+bool pgo_bench(Cmd *cmd, const char *what, float *p50, float *p95) {
+    if (!build_host()) return false;
+    run_bench(cmd, "bitmap"); // over the limits is still a result
+    if (!bench_frame_times(temp_sprintf("%s/bench_frames.csv", host_dir()), p50, p95)) {
+        nob_log(NOB_ERROR, "no frame times from the %s build", what);
+        return false;
+    }
+    return true;
+}
+
+// merges the raw profiles into one named after its contents, so it's part
+// of the object cache key and a new profile never meets an old object
+bool pgo_merge(Cmd *cmd, const File_Paths *raw) {
+    const char *ndk = getenv("ANDROID_NDK_ROOT");
+    const char *profdata = ndk ? temp_sprintf("%s/toolchains/llvm/prebuilt/linux-x86_64/bin/llvm-profdata", ndk) : "llvm-profdata";
+    const char *merged = PGO_DIR"/merged.profdata";
+    cmd_append(cmd, profdata, "merge", "-o", merged);
+    da_append_many(cmd, raw->items, raw->count);
+    if (!cmd_run(cmd)) return false;
+    String_Builder sb = {0};
+    if (!read_entire_file(merged, &sb)) return false;
+    pgo_key = fnv1a(14695981039346656037ull, sb.items, sb.count);
+    da_free(sb);
+    pgo_profdata = temp_sprintf(PGO_DIR"/%016llx.profdata", (unsigned long long)pgo_key);
+    return nob_rename(merged, pgo_profdata);
+}
+
+bool run_pgo(Cmd *cmd) {
+    if (!mkdir_if_not_exists("build")) return false;
+    if (!mkdir_if_not_exists(PGO_DIR)) return false;
+    if (!mkdir_if_not_exists(PGO_RAW_DIR)) return false;
+    pgo_clang = host_cc_is_clang();
+
+    float base_p50, base_p95;
+    if (!pgo_bench(cmd, "plain", &base_p50, &base_p95)) return false;
+
+    if (!pgo_clear()) return false;
+    if (!pgo_stage(PGO_GENERATE)) return false;
+    if (!build_host()) return false;
+    nob_log(NOB_INFO, "Training on "BENCH_SESSION);
+    run_bench(cmd, "bitmap");
+    File_Paths raw = {0};
+    walk_dir(PGO_RAW_DIR, collect_profiles, .data = &raw);
+    if (raw.count == 0) {
+        nob_log(NOB_ERROR, "the instrumented build wrote no profiles to "PGO_RAW_DIR);
+        return false;
+    }
+    if (pgo_clang) {
+        if (!pgo_merge(cmd, &raw)) return false;
+    } else {
+        // gcc reads the .gcda files where they are, the key only has to change with them
+        pgo_key = 14695981039346656037ull;
+        for (size_t i = 0; i < raw.count; i++) {
+            String_Builder sb = {0};
+            if (!read_entire_file(raw.items[i], &sb)) return false;
+            pgo_key = fnv1a(fnv1a(pgo_key, raw.items[i], strlen(raw.items[i])), sb.items, sb.count);
+            da_free(sb);
+        }
+    }
+    da_free(raw);
+
+    float pgo_p50, pgo_p95;
+    if (!pgo_stage(PGO_USE)) return false;
+    if (!pgo_bench(cmd, "PGO", &pgo_p50, &pgo_p95)) return false;
+    nob_log(NOB_INFO, "%s on "BENCH_SESSION", plain -> PGO:", profile->name);
+    nob_log(NOB_INFO, "  p50 %6.2f -> %6.2f ms (%+.1f%%)", base_p50, pgo_p50, 100.0f*(pgo_p50 - base_p50)/base_p50);
+    nob_log(NOB_INFO, "  p95 %6.2f -> %6.2f ms (%+.1f%%)", base_p95, pgo_p95, 100.0f*(pgo_p95 - base_p95)/base_p95);
+
+    if (!pgo_clang) {
+        nob_log(NOB_INFO, "host cc is gcc, whose profiles the NDK's clang can't read: skipping libmain.so");
+        return true;
+    }
+    if (!setup_paths()) return false;
+    Abi_List targets = {0};
+    for (size_t i = 0; i < ARRAY_LEN(abis); i++) da_append(&targets, &abis[i]);
+    bool ok = build_apk(&targets);
+    da_free(targets);
+    return ok;
+}
+
 bool install_apk(Cmd *cmd) {
     bool result = true;
     size_t checkpoint = temp_save();
@@ -529,19 +1963,43 @@ bool install_apk(Cmd *cmd) {
 	// $(ANDROID_PLATFORM_TOOLS)/adb install $(PROJECT_NAME).apk
     cmd_append(cmd, temp_sprintf("%s/platform-tools/adb", sdk_path));
     cmd_append(cmd, "install");
-    cmd_append(cmd, "build/"APP_NAME".apk");
+    cmd_append(cmd, temp_sprintf("%s/"APP_NAME".apk", profile_dir()));
     if (!cmd_run(cmd)) return_defer(false);
 defer:
     temp_rewind(checkpoint);
     return result;
 }
 
+// cold-starts the installed app and waits for its first frame; `am start -W`
+// prints how long that took (TotalTime), which is where loading libmain.so
+// and applying its relocations shows up
+bool launch_apk(Cmd *cmd) {
+    cmd_append(cmd, temp_sprintf("%s/platform-tools/adb", sdk_path));
+    cmd_append(cmd, "shell", "am", "start");
+    cmd_append(cmd, "-W"); // wait for the launch to finish and report its timings
+    cmd_append(cmd, "-S"); // force-stop it first, so it's a cold start
+    cmd_append(cmd, "-n", "com."APP_AUTHOR"."APP_NAME"/.NativeLoader");
+    return cmd_run(cmd);
+}
+
 void usage(const char *prog, FILE *out) {
-    fprintf(out, "%s [build|install|deploy]\n", prog);
-    fprintf(out, "  -h,--help   print this help\n");
-    fprintf(out, "  build       build APK [default when no arg provided]\n");
-    fprintf(out, "  install     build and install APK to connected device\n");
-    fprintf(out, "  deploy      like `install`, but also opens logcat for debugging\n");
+    fprintf(out, "%s [options] [build|install|launch|deploy|bench|bench-sdf|bench-profiles|pgo|bench-rules|test|sim [options]]\n", prog);
+    fprintf(out, "  -h,--help       print this help\n");
+    fprintf(out, "  --profile NAME  debug, release or relwithdebinfo, for the APK and the host build [default: release]\n");
+    fprintf(out, "  --abi NAME      build only this ABI (arm64-v8a, armeabi-v7a or x86_64), may be repeated [default: all]\n");
+    fprintf(out, "  --unity         compile raylib and main.c as one translation unit, into build/<profile>-unity/\n");
+    fprintf(out, "  --faces NAME    bitmap or sdf card faces for the APK, sdf leaves the card PNGs out [default: bitmap]\n");
+    fprintf(out, "  build           build APK [default when no arg provided]\n");
+    fprintf(out, "  install         build and install APK to connected device\n");
+    fprintf(out, "  launch          like `install`, then cold-start the app and report how long it took\n");
+    fprintf(out, "  deploy          like `install`, but also opens logcat for debugging\n");
+    fprintf(out, "  bench           build the headless host binary and replay " BENCH_SESSION " against it\n");
+    fprintf(out, "  bench-sdf       like `bench`, drawing the cards from signed distance fields instead of the PNGs\n");
+    fprintf(out, "  bench-profiles  run `bench` in every profile and compare binary size and frame time\n");
+    fprintf(out, "  pgo             train on the bench replay and rebuild with the profile, reporting the speedup\n");
+    fprintf(out, "  bench-rules     build and run the rules engine micro-benchmarks\n");
+    fprintf(out, "  test            build and run the host tests in tests/\n");
+    fprintf(out, "  sim             build and run the Monte Carlo simulator, options go to it (try `sim --help`)\n");
 }
 
 typedef struct {
@@ -552,19 +2010,56 @@ typedef struct {
 
 typedef struct {
     bool help;
+    Abi_List abis;
     Arg_List rest;
 } Args;
 
 bool parse_args(Args *args, char **argv, int argc) {
     while (argc) {
         String_View arg = sv_from_cstr(*argv);
-        if (*arg.data == '-') {
+        // anything after the command belongs to it (`./nob sim --games 1000`)
+        if (args->rest.count == 0 && *arg.data == '-') {
             while (arg.count && *arg.data == '-') {
                 arg.data += 1;
                 arg.count -= 1;
             }
             if (sv_eq(arg, sv_from_cstr("h")) || sv_eq(arg, sv_from_cstr("help"))) {
                 args->help = true;
+            } else if (sv_eq(arg, sv_from_cstr("profile"))) {
+                if (argc < 2) {
+                    nob_log(NOB_ERROR, "%s needs a profile name", *argv);
+                    return false;
+                }
+                argc--;
+                argv++;
+                profile = find_profile(*argv);
+                if (!profile) {
+                    nob_log(NOB_ERROR, "Unknown profile: %s", *argv);
+                    return false;
+                }
+            } else if (sv_eq(arg, sv_from_cstr("abi"))) {
+                if (argc < 2) {
+                    nob_log(NOB_ERROR, "%s needs an ABI name", *argv);
+                    return false;
+                }
+                argc--;
+                argv++;
+                const Abi *abi = find_abi(*argv);
+                if (!abi) {
+                    nob_log(NOB_ERROR, "Unknown ABI: %s", *argv);
+                    return false;
+                }
+                da_append(&args->abis, abi);
+            } else if (sv_eq(arg, sv_from_cstr("unity"))) {
+                unity = true;
+            } else if (sv_eq(arg, sv_from_cstr("faces"))) {
+                if (argc < 2 || (strcmp(argv[1], "sdf") != 0 && strcmp(argv[1], "bitmap") != 0)) {
+                    nob_log(NOB_ERROR, "%s needs bitmap or sdf", *argv);
+                    return false;
+                }
+                argc--;
+                argv++;
+                sdf_faces = strcmp(*argv, "sdf") == 0;
             } else {
                 nob_log(NOB_ERROR, "Unrecognized flag: %s\n", *argv);
                 return false;
@@ -581,31 +2076,74 @@ bool parse_args(Args *args, char **argv, int argc) {
 int main(int argc, char *argv[]) {
     NOB_GO_REBUILD_URSELF(argc, argv);
     Cmd cmd = {0};
-    Procs procs = {0};
-    Pipes pipes = {0};
     const char *prog = shift(argv, argc);
     Args args = {0};
     if (!parse_args(&args, argv, argc)) {
         usage(prog, stderr);
         return 1;
     }
-    if (!setup_paths()) return 1;
     if (args.help) {
         usage(prog, stdout);
         return 0;
     }
+    // the host benchmark doesn't need the Android toolchain
+    if (args.rest.count > 0 && strcmp(args.rest.items[0], "bench") == 0) {
+        if (!build_host()) return 1;
+        if (!run_bench(&cmd, "bitmap")) return 1;
+        return 0;
+    }
+    if (args.rest.count > 0 && strcmp(args.rest.items[0], "bench-sdf") == 0) {
+        if (!build_host()) return 1;
+        if (!run_bench(&cmd, "sdf")) return 1;
+        return 0;
+    }
+    if (args.rest.count > 0 && strcmp(args.rest.items[0], "bench-profiles") == 0) {
+        if (!bench_profiles(&cmd)) return 1;
+        return 0;
+    }
+    if (args.rest.count > 0 && strcmp(args.rest.items[0], "pgo") == 0) {
+        if (!run_pgo(&cmd)) return 1;
+        return 0;
+    }
+    if (args.rest.count > 0 && strcmp(args.rest.items[0], "bench-rules") == 0) {
+        if (!build_bench_rules(&cmd)) return 1;
+        cmd_append(&cmd, "./build/host/bench_rules");
+        if (!cmd_run(&cmd)) return 1;
+        return 0;
+    }
+    if (args.rest.count > 0 && strcmp(args.rest.items[0], "test") == 0) {
+        if (!build_test_stats(&cmd)) return 1;
+        cmd_append(&cmd, "./build/host/test_stats");
+        if (!cmd_run(&cmd)) return 1;
+        return 0;
+    }
+    if (args.rest.count > 0 && strcmp(args.rest.items[0], "sim") == 0) {
+        if (!build_sim(&cmd)) return 1;
+        cmd_append(&cmd, "./build/host/sim");
+        for (size_t i = 1; i < args.rest.count; i++) cmd_append(&cmd, args.rest.items[i]);
+        if (!cmd_run(&cmd)) return 1;
+        return 0;
+    }
+    if (!setup_paths()) return 1;
+    if (args.abis.count == 0) {
+        for (size_t i = 0; i < ARRAY_LEN(abis); i++) da_append(&args.abis, &abis[i]);
+    }
     if (args.rest.count == 0) {
         // just do the build
-        if (!build_apk(&cmd, &procs, &pipes)) return 1;
+        if (!build_apk(&args.abis)) return 1;
     } else {
         const char *arg = shift(args.rest.items, args.rest.count);
         if (strcmp(arg, "build") == 0) {
-            if (!build_apk(&cmd, &procs, &pipes)) return 1;
+            if (!build_apk(&args.abis)) return 1;
         } else if (strcmp(arg, "install") == 0) {
-            if (!build_apk(&cmd, &procs, &pipes)) return 1;
+            if (!build_apk(&args.abis)) return 1;
+            if (!install_apk(&cmd)) return 1;
+        } else if (strcmp(arg, "launch") == 0) {
+            if (!build_apk(&args.abis)) return 1;
             if (!install_apk(&cmd)) return 1;
+            if (!launch_apk(&cmd)) return 1;
         } else if (strcmp(arg, "deploy") == 0) {
-            if (!build_apk(&cmd, &procs, &pipes)) return 1;
+            if (!build_apk(&args.abis)) return 1;
             if (!install_apk(&cmd)) return 1;
             cmd_append(&cmd, temp_sprintf("%s/platform-tools/adb", sdk_path));
             cmd_append(&cmd, "logcat", "-c");
@@ -0,0 +1,240 @@
+// profiler.h - per-frame timing recorder
+//
+// Each frame is split into a fixed set of stages (update, render, swap, sleep).
+// The game thread times the stages of the current frame and publishes the
+// finished frame into a ring buffer. Publishing is a single release store of
+// the write counter, so readers (the report/dump code, possibly on another
+// thread) never take a lock and never block the frame. The ring keeps the
+// last PROFILER_CAPACITY frames unless prof_init() is asked for more, e.g. a
+// benchmark that wants every frame of its run.
+//
+// Define PROFILER_IMPLEMENTATION in exactly one translation unit before
+// including this header. If raylib.h was included first, an on-screen frame
+// graph is provided as well.
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    STAGE_UPDATE,
+    STAGE_RENDER,
+    STAGE_SWAP,
+    STAGE_SLEEP,
+    STAGE_COUNT,
+} Frame_Stage;
+
+extern const char *frame_stage_names[STAGE_COUNT];
+
+typedef struct {
+    float t[STAGE_COUNT]; // seconds spent in each stage
+} Frame_Sample;
+
+#define PROFILER_CAPACITY 1024 // default ring size, must be a power of two
+
+typedef struct {
+    Frame_Sample *samples;
+    size_t capacity;  // a power of two
+    uint64_t written; // number of frames published so far, only advanced by the producer
+    Frame_Sample current;
+    double stage_start[STAGE_COUNT];
+} Frame_Profiler;
+
+typedef struct {
+    size_t frames;
+    // index STAGE_COUNT holds the whole frame
+    float p50[STAGE_COUNT+1];
+    float p95[STAGE_COUNT+1];
+    float p99[STAGE_COUNT+1];
+} Frame_Report;
+
+// keeps the last `frames` frames, rounded up to a power of two; call before
+// anything else, false if the ring couldn't be allocated
+bool prof_init(Frame_Profiler *p, size_t frames);
+double prof_now(void);
+void prof_begin(Frame_Profiler *p, Frame_Stage stage);
+void prof_end(Frame_Profiler *p, Frame_Stage stage);
+// publish the current frame and start a new one
+void prof_commit(Frame_Profiler *p);
+// copies out up to `cap` of the most recent frames, oldest first
+size_t prof_snapshot(const Frame_Profiler *p, Frame_Sample *out, size_t cap);
+Frame_Report prof_report(const Frame_Profiler *p);
+// nearest rank of `pct` (0..100) in `sorted`, which has `n` > 0 values sorted
+// with prof_cmp_float; every percentile the game and its tools report uses this
+float prof_percentile(const float *sorted, size_t n, float pct);
+int prof_cmp_float(const void *a, const void *b);
+bool prof_write_csv(const Frame_Profiler *p, const char *path);
+
+#ifdef RAYLIB_H
+// stacked bar per frame, newest on the right; `budget` (seconds) is drawn as a line
+void prof_draw_graph(const Frame_Profiler *p, Rectangle bounds, float budget);
+#endif
+
+#endif // PROFILER_H_
+
+#ifdef PROFILER_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+const char *frame_stage_names[STAGE_COUNT] = {
+    [STAGE_UPDATE] = "update",
+    [STAGE_RENDER] = "render",
+    [STAGE_SWAP]   = "swap",
+    [STAGE_SLEEP]  = "sleep",
+};
+
+bool prof_init(Frame_Profiler *p, size_t frames)
+{
+    size_t capacity = 1;
+    while (capacity < frames) capacity *= 2;
+    *p = (Frame_Profiler) { .samples = calloc(capacity, sizeof(Frame_Sample)), .capacity = capacity };
+    return p->samples != NULL;
+}
+
+double prof_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+void prof_begin(Frame_Profiler *p, Frame_Stage stage)
+{
+    p->stage_start[stage] = prof_now();
+}
+
+void prof_end(Frame_Profiler *p, Frame_Stage stage)
+{
+    p->current.t[stage] += (float)(prof_now() - p->stage_start[stage]);
+}
+
+void prof_commit(Frame_Profiler *p)
+{
+    uint64_t n = p->written;
+    p->samples[n & (p->capacity-1)] = p->current;
+    __atomic_store_n(&p->written, n+1, __ATOMIC_RELEASE);
+    p->current = (Frame_Sample) {0};
+}
+
+size_t prof_snapshot(const Frame_Profiler *p, Frame_Sample *out, size_t cap)
+{
+    if (cap > p->capacity) cap = p->capacity;
+    uint64_t end = __atomic_load_n(&p->written, __ATOMIC_ACQUIRE);
+    uint64_t start = end > cap ? end - cap : 0;
+    for (uint64_t i = start; i < end; i++) {
+        out[i-start] = p->samples[i & (p->capacity-1)];
+    }
+    // the producer may have lapped us while copying, drop anything it overwrote;
+    // it may also be part way through writing frame `after`, whose slot is frame
+    // `after - capacity`'s
+    uint64_t after = __atomic_load_n(&p->written, __ATOMIC_ACQUIRE);
+    uint64_t valid = after + 1 > p->capacity ? after + 1 - p->capacity : 0;
+    if (valid > start) {
+        size_t skip = valid - start;
+        if (skip >= end - start) return 0;
+        for (size_t i = skip; i < end - start; i++) out[i-skip] = out[i];
+        return end - start - skip;
+    }
+    return end - start;
+}
+
+int prof_cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+float prof_percentile(const float *sorted, size_t n, float pct)
+{
+    size_t rank = (size_t)(pct/100.0f*n + 0.5f);
+    if (rank > 0) rank--;
+    if (rank >= n) rank = n-1;
+    return sorted[rank];
+}
+
+Frame_Report prof_report(const Frame_Profiler *p)
+{
+    Frame_Report report = {0};
+    Frame_Sample *samples = malloc(p->capacity*sizeof(*samples));
+    float *values = malloc(p->capacity*sizeof(*values));
+    size_t n = samples && values ? prof_snapshot(p, samples, p->capacity) : 0;
+    report.frames = n;
+    for (size_t s = 0; s <= STAGE_COUNT && n > 0; s++) {
+        for (size_t i = 0; i < n; i++) {
+            if (s < STAGE_COUNT) {
+                values[i] = samples[i].t[s];
+            } else {
+                values[i] = 0;
+                for (size_t k = 0; k < STAGE_COUNT; k++) values[i] += samples[i].t[k];
+            }
+        }
+        qsort(values, n, sizeof(*values), prof_cmp_float);
+        report.p50[s] = prof_percentile(values, n, 50);
+        report.p95[s] = prof_percentile(values, n, 95);
+        report.p99[s] = prof_percentile(values, n, 99);
+    }
+    free(samples);
+    free(values);
+    return report;
+}
+
+bool prof_write_csv(const Frame_Profiler *p, const char *path)
+{
+    Frame_Sample *samples = malloc(p->capacity*sizeof(*samples));
+    if (!samples) return false;
+    size_t n = prof_snapshot(p, samples, p->capacity);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        free(samples);
+        return false;
+    }
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        fprintf(f, "%s%s", s ? "," : "", frame_stage_names[s]);
+    }
+    fprintf(f, "\n");
+    for (size_t i = 0; i < n; i++) {
+        for (size_t s = 0; s < STAGE_COUNT; s++) {
+            fprintf(f, "%s%f", s ? "," : "", samples[i].t[s]*1000.0f);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    free(samples);
+    return true;
+}
+
+#ifdef RAYLIB_H
+void prof_draw_graph(const Frame_Profiler *p, Rectangle bounds, float budget)
+{
+    static const Color stage_colors[STAGE_COUNT] = {
+        [STAGE_UPDATE] = { 0, 121, 241, 200 },
+        [STAGE_RENDER] = { 253, 249, 0, 200 },
+        [STAGE_SWAP]   = { 230, 41, 55, 200 },
+        [STAGE_SLEEP]  = { 130, 130, 130, 120 },
+    };
+    static Frame_Sample samples[PROFILER_CAPACITY];
+    size_t width = (size_t)bounds.width;
+    size_t n = prof_snapshot(p, samples, width < PROFILER_CAPACITY ? width : PROFILER_CAPACITY);
+    // vertical scale: twice the budget fills the graph
+    float scale = bounds.height/(2.0f*budget);
+    DrawRectangleRec(bounds, (Color){ 0, 0, 0, 120 });
+    for (size_t i = 0; i < n; i++) {
+        float x = bounds.x + bounds.width - n + i;
+        float y = bounds.y + bounds.height;
+        for (size_t s = 0; s < STAGE_COUNT; s++) {
+            float h = samples[i].t[s]*scale;
+            if (y - h < bounds.y) h = y - bounds.y;
+            DrawRectangleRec((Rectangle){ x, y - h, 1, h }, stage_colors[s]);
+            y -= h;
+        }
+    }
+    float budget_y = bounds.y + bounds.height - budget*scale;
+    DrawLineV((Vector2){ bounds.x, budget_y }, (Vector2){ bounds.x + bounds.width, budget_y }, WHITE);
+}
+#endif
+
+#endif // PROFILER_IMPLEMENTATION
@@ -0,0 +1,476 @@
+// solitaire.h - Klondike rules: cards, piles, dealing and move generation
+//
+// Nothing in here draws or reads input, so the game, the benchmarks and any
+// offline tooling share the exact same rules. Card positions ride along in
+// the Card struct for the renderer, which is the only reason raylib.h is
+// pulled in (for Vector2).
+//
+// Define SOLITAIRE_IMPLEMENTATION in exactly one translation unit before
+// including this header.
+#ifndef SOLITAIRE_H_
+#define SOLITAIRE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+enum face {
+    FACE_ACE = 1,
+    FACE_JACK = 11,
+    FACE_QUEEN = 12,
+    FACE_KING = 13,
+    FACE_COUNT,
+};
+
+enum suit {
+    HEARTS,
+    CLUBS,
+    SPADES,
+    DIAMONDS,
+    SUIT_COUNT,
+};
+
+typedef struct {
+    int value;
+    enum suit suit;
+    Vector2 pos;
+    bool revealed;
+} Card;
+
+static inline bool is_black(Card c)
+{
+    return c.suit == SPADES || c.suit == CLUBS;
+}
+
+// static inline bool is_red(Card c)
+// {
+//     return !is_black(c);
+// }
+
+// A pile is a span of a Card arena: `cap` slots starting at `offset`, the
+// first `count` of them in use. The game's piles all live in Game.cards, so
+// copying a Game copies every card with it and nothing points outside it.
+typedef struct {
+    uint16_t offset;
+    uint16_t count;
+    uint16_t cap;
+} Pile;
+
+typedef struct {
+    Card *data;
+    size_t count;
+} Pile_View;
+
+static inline Card *pile_cards(Card *arena, const Pile *pile)
+{
+    return arena + pile->offset;
+}
+
+void pile_append(Card *arena, Pile *pile, Card card);
+void pile_append_many(Card *arena, Pile *dst, Pile_View src);
+Card pile_pop(const Card *arena, Pile *pile);
+Card pile_peek(const Card *arena, const Pile *pile);
+Card pile_first(const Card *arena, const Pile *pile);
+// takes the cards from `split` up off `src`; they stay in src's slots, so the
+// view is only good until something is appended to `src` again
+Pile_View pile_split(Card *arena, Pile *src, size_t split);
+Pile_View pile_view(Card *arena, const Pile *src, size_t start, size_t n);
+
+// Klondike is one deck; the two-deck games are in board.h
+#define DECK_CARDS 52
+#define TABLEAU_COLS 7
+#define FOUNDATION_COLS 4
+#define TABLEAU_DEALT (TABLEAU_COLS*(TABLEAU_COLS+1)/2)
+// column i holds at most its i face-down cards and a king-to-ace run; the
+// reserve and the talon each hold at most whatever wasn't dealt
+#define TABLEAU_CAP(i) ((i) + 13)
+#define GAME_ARENA_CARDS (TABLEAU_COLS*(TABLEAU_COLS-1)/2 + TABLEAU_COLS*13 + \
+                          FOUNDATION_COLS*13 + 2*(DECK_CARDS - TABLEAU_DEALT))
+typedef struct {
+    Card cards[GAME_ARENA_CARDS]; // every pile below is a span of this
+    Pile tableau[TABLEAU_COLS];
+    Pile foundation[FOUNDATION_COLS];
+    Pile talon;
+    Pile reserve;
+    int redeals; // times the talon has been turned back over onto the reserve
+} Game;
+
+#define REDEALS_UNLIMITED -1
+
+// Rule variants: how many cards a tap on the reserve turns over and how many
+// times the talon may be turned back over. Each one gets its own
+// listMoves_<name>()/applyMove_<name>() with the rules baked in as constants,
+// so a playout loop built on them never branches on which rules are in play.
+//      name         draw  redeals
+#define SOLITAIRE_VARIANTS(X) \
+    X(draw1,       1,    REDEALS_UNLIMITED) \
+    X(draw3,       3,    REDEALS_UNLIMITED) \
+    X(draw1_vegas, 1,    0)                 \
+    X(draw3_vegas, 3,    2)
+
+typedef enum {
+    PILE_TABLEAU,
+    PILE_FOUNDATION,
+    PILE_TALON,
+    PILE_RESERVE,
+} Pile_Kind;
+
+typedef struct {
+    Pile_Kind kind;
+    int index; // column for tableau/foundation, 0 otherwise
+} Pile_Ref;
+
+// A move is what a single tap does: the run starting at `start` in `from`
+// goes to `to`. Tapping the reserve draws (reserve -> talon) or, once the
+// reserve is empty, turns the talon back over (talon -> reserve).
+typedef struct {
+    Pile_Ref from;
+    Pile_Ref to;
+    int start;
+} Move;
+
+// upper bound on listMoves(): every tableau card, the foundation tops, the talon top and the reserve
+#define MAX_MOVES (TABLEAU_COLS*13 + FOUNDATION_COLS + 2)
+
+// splitmix64: our own generator so a deal seed gives the same deal on every
+// platform (bionic and glibc rand() differ), which replays rely on
+uint64_t rng_next(uint64_t *state);
+// uniform in [0, n)
+uint32_t rng_below(uint64_t *state, uint32_t n);
+
+Pile *game_pile(Game *game, Pile_Ref ref);
+void dealGame(Game *game, uint64_t seed);
+// whether `candidate` may be put on top of `target`
+bool pileAccepts(const Game *game, Pile_View candidate, Pile_Ref target);
+// where tapping `candidate` sends it: the first foundation that takes it,
+// then the first tableau column; false if it can't go anywhere
+bool findMoveTarget(const Game *game, Pile_View candidate, Pile_Ref *target);
+// turn the talon over onto the reserve, which then deals it again in the same order
+void game_recycle_talon(Game *game);
+bool isWon(const Game *game);
+// whether `move` leaves a face-down tableau card on top, to be turned over
+bool revealsCard(const Game *game, Move move);
+
+// every tap that changes the game, returns the number of moves written to `moves` (at most MAX_MOVES)
+//     size_t listMoves_<variant>(Game *game, Move *moves);
+//     void applyMove_<variant>(Game *game, Move move);
+#define SOLITAIRE_DECLARE_VARIANT(name, draw, redeals) \
+    size_t listMoves_##name(Game *game, Move *moves); \
+    void applyMove_##name(Game *game, Move move);
+SOLITAIRE_VARIANTS(SOLITAIRE_DECLARE_VARIANT)
+
+#endif // SOLITAIRE_H_
+
+#ifdef SOLITAIRE_IMPLEMENTATION
+
+#include <assert.h>
+#include <string.h>
+
+void pile_append(Card *arena, Pile *pile, Card card) {
+    assert(pile->count < pile->cap);
+    arena[pile->offset + pile->count++] = card;
+}
+
+void pile_append_many(Card *arena, Pile *dst, Pile_View src) {
+    assert(dst->count + src.count <= dst->cap);
+    memcpy(arena + dst->offset + dst->count, src.data, src.count*sizeof(*src.data));
+    dst->count += src.count;
+}
+
+Card pile_pop(const Card *arena, Pile *pile) {
+    assert(pile->count > 0);
+    return arena[pile->offset + --pile->count];
+}
+
+Card pile_peek(const Card *arena, const Pile *pile) {
+    assert(pile->count > 0);
+    return arena[pile->offset + pile->count-1];
+}
+
+Card pile_first(const Card *arena, const Pile *pile) {
+    assert(pile->count > 0);
+    return arena[pile->offset];
+}
+
+Pile_View pile_split(Card *arena, Pile *src, size_t split)
+{
+    assert(split < src->count);
+    Pile_View run = pile_view(arena, src, split, src->count - split);
+    src->count = split;
+    return run;
+}
+
+Pile_View pile_view(Card *arena, const Pile *src, size_t start, size_t n)
+{
+    return CLITERAL(Pile_View) {
+        .data = arena + src->offset + start,
+        .count = n,
+    };
+}
+
+uint64_t rng_next(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint32_t rng_below(uint64_t *state, uint32_t n)
+{
+    return (uint32_t)(((rng_next(state) >> 32) * n) >> 32);
+}
+
+Pile *game_pile(Game *game, Pile_Ref ref)
+{
+    switch (ref.kind) {
+    case PILE_TABLEAU:    return &game->tableau[ref.index];
+    case PILE_FOUNDATION: return &game->foundation[ref.index];
+    case PILE_TALON:      return &game->talon;
+    case PILE_RESERVE:    return &game->reserve;
+    }
+    assert(0 && "unreachable");
+    return NULL;
+}
+
+// lay the piles out back to back in the arena
+static void game_layout(Game *game)
+{
+    uint16_t offset = 0;
+    for (int i = 0; i < TABLEAU_COLS; i++) {
+        game->tableau[i] = CLITERAL(Pile) { offset, 0, TABLEAU_CAP(i) };
+        offset += TABLEAU_CAP(i);
+    }
+    for (int i = 0; i < FOUNDATION_COLS; i++) {
+        game->foundation[i] = CLITERAL(Pile) { offset, 0, 13 };
+        offset += 13;
+    }
+    game->talon = CLITERAL(Pile) { offset, 0, DECK_CARDS - TABLEAU_DEALT };
+    offset += game->talon.cap;
+    game->reserve = CLITERAL(Pile) { offset, 0, DECK_CARDS - TABLEAU_DEALT };
+    offset += game->reserve.cap;
+    assert(offset == GAME_ARENA_CARDS);
+}
+
+void dealGame(Game *game, uint64_t seed)
+{
+    uint64_t rng = seed;
+    *game = (Game) {0};
+    game_layout(game);
+    Card deck[DECK_CARDS];
+    // Init deck
+    for (int i = 0; i < DECK_CARDS; i++) {
+        deck[i] = CLITERAL(Card) {
+            .value = (i/SUIT_COUNT) % 13 + 1,
+            .suit = i % SUIT_COUNT,
+            .pos = {0},
+            .revealed = false,
+        };
+    }
+
+    // Shuffle deck (Fisher-Yates algorithm)
+    for (int i = DECK_CARDS-1; i > 0; i--) {
+        int r = rng_below(&rng, i+1); // card to swap with
+        Card tmp = deck[r];
+        deck[r] = deck[i];
+        deck[i] = tmp;
+    }
+
+    // Deal cards to foundation
+    int top = DECK_CARDS;
+    for (int i = 0; i < TABLEAU_COLS; i++) {
+        for (int j = 0; j < i+1; j++) {
+            pile_append(game->cards, &game->tableau[i], deck[--top]);
+        }
+        pile_cards(game->cards, &game->tableau[i])[i].revealed = true;
+    }
+
+    // Deal remaining to reserve
+    while (top > 0) {
+        pile_append(game->cards, &game->reserve, deck[--top]);
+    }
+}
+
+bool pileAccepts(const Game *game, Pile_View candidate, Pile_Ref target)
+{
+    Card c = candidate.data[0];
+    switch (target.kind) {
+    case PILE_FOUNDATION: {
+        const Pile *p = &game->foundation[target.index];
+        if (p->count == 0) return c.value == FACE_ACE;
+        Card last = pile_peek(game->cards, p);
+        return c.suit == last.suit && c.value == last.value + 1 && candidate.count == 1;
+    }
+    case PILE_TABLEAU: {
+        const Pile *p = &game->tableau[target.index];
+        if (p->count == 0) return c.value == FACE_KING;
+        Card last = pile_peek(game->cards, p);
+        bool different = is_black(c) ^ is_black(last);
+        return different && c.value == last.value - 1;
+    }
+    default:
+        return false; // the talon and reserve are only ever dealt to
+    }
+}
+
+bool findMoveTarget(const Game *game, Pile_View candidate, Pile_Ref *target)
+{
+    for (int i = 0; i < FOUNDATION_COLS; i++) {
+        Pile_Ref ref = { PILE_FOUNDATION, i };
+        if (pileAccepts(game, candidate, ref)) {
+            *target = ref;
+            return true;
+        }
+    }
+    for (int i = 0; i < TABLEAU_COLS; i++) {
+        Pile_Ref ref = { PILE_TABLEAU, i };
+        if (pileAccepts(game, candidate, ref)) {
+            *target = ref;
+            return true;
+        }
+    }
+    return false;
+}
+
+// findMoveTarget() answers for one card by scanning every pile. listMoves()
+// asks for every card in the game, so it builds the answers for all cards up
+// front: for each card, the first pile (in findMoveTarget's order) that takes it.
+typedef struct {
+    int8_t foundation[SUIT_COUNT][FACE_COUNT]; // single card onto a foundation, -1 if none
+    int8_t tableau[2][FACE_COUNT];             // [is_black][value], -1 if none
+    int8_t empty_foundation;                   // first empty foundation, for aces
+    int8_t empty_tableau;                      // first empty column, for kings
+} Move_Targets;
+
+static void buildMoveTargets(const Game *game, Move_Targets *t)
+{
+    memset(t, -1, sizeof(*t));
+    for (int i = FOUNDATION_COLS-1; i >= 0; i--) {
+        const Pile *p = &game->foundation[i];
+        if (p->count == 0) {
+            t->empty_foundation = i;
+        } else {
+            Card last = pile_peek(game->cards, p);
+            if (last.value < FACE_KING) t->foundation[last.suit][last.value+1] = i;
+        }
+    }
+    for (int i = TABLEAU_COLS-1; i >= 0; i--) {
+        const Pile *p = &game->tableau[i];
+        if (p->count == 0) {
+            t->empty_tableau = i;
+        } else {
+            Card last = pile_peek(game->cards, p);
+            if (last.value > FACE_ACE) t->tableau[!is_black(last)][last.value-1] = i;
+        }
+    }
+}
+
+static inline bool lookupMoveTarget(const Move_Targets *t, Card c, size_t count, Pile_Ref *target)
+{
+    int i = -1;
+    if (c.value == FACE_ACE) i = t->empty_foundation;
+    else if (count == 1) i = t->foundation[c.suit][c.value];
+    if (i >= 0) {
+        *target = CLITERAL(Pile_Ref) { PILE_FOUNDATION, i };
+        return true;
+    }
+    i = c.value == FACE_KING ? t->empty_tableau : t->tableau[is_black(c)][c.value];
+    if (i >= 0) {
+        *target = CLITERAL(Pile_Ref) { PILE_TABLEAU, i };
+        return true;
+    }
+    return false;
+}
+
+static inline __attribute__((always_inline))
+size_t listMovesWith(Game *game, Move *moves, int redeals)
+{
+    Move_Targets targets;
+    buildMoveTargets(game, &targets);
+    size_t n = 0;
+    Pile_Ref to;
+    for (int i = 0; i < TABLEAU_COLS; i++) {
+        Pile *p = &game->tableau[i];
+        Card *cards = pile_cards(game->cards, p);
+        for (int j = 0; j < p->count; j++) {
+            if (!cards[j].revealed) continue;
+            if (lookupMoveTarget(&targets, cards[j], p->count-j, &to)) {
+                moves[n++] = CLITERAL(Move) { { PILE_TABLEAU, i }, to, j };
+            }
+        }
+    }
+    for (int i = 0; i < FOUNDATION_COLS; i++) {
+        Pile *p = &game->foundation[i];
+        if (p->count > 0 && lookupMoveTarget(&targets, pile_peek(game->cards, p), 1, &to)) {
+            moves[n++] = CLITERAL(Move) { { PILE_FOUNDATION, i }, to, p->count-1 };
+        }
+    }
+    if (game->talon.count > 0) {
+        Pile *p = &game->talon;
+        if (lookupMoveTarget(&targets, pile_peek(game->cards, p), 1, &to)) {
+            moves[n++] = CLITERAL(Move) { { PILE_TALON, 0 }, to, p->count-1 };
+        }
+    }
+    if (game->reserve.count > 0) {
+        moves[n++] = CLITERAL(Move) { { PILE_RESERVE, 0 }, { PILE_TALON, 0 }, game->reserve.count-1 };
+    } else if (game->talon.count > 0 && (redeals == REDEALS_UNLIMITED || game->redeals < redeals)) {
+        moves[n++] = CLITERAL(Move) { { PILE_TALON, 0 }, { PILE_RESERVE, 0 }, 0 };
+    }
+    assert(n <= MAX_MOVES);
+    return n;
+}
+
+static inline __attribute__((always_inline))
+void applyMoveWith(Game *game, Move move, int draw)
+{
+    Pile *from = game_pile(game, move.from);
+    Pile *to = game_pile(game, move.to);
+    if (move.from.kind == PILE_RESERVE) {
+        for (int i = 0; i < draw && from->count > 0; i++) {
+            Card c = pile_pop(game->cards, from);
+            c.revealed = true;
+            pile_append(game->cards, to, c);
+        }
+    } else if (move.to.kind == PILE_RESERVE) {
+        game_recycle_talon(game);
+    } else {
+        pile_append_many(game->cards, to, pile_split(game->cards, from, move.start));
+        if (move.from.kind == PILE_TABLEAU && from->count > 0) {
+            pile_cards(game->cards, from)[from->count-1].revealed = true;
+        }
+    }
+}
+
+#define SOLITAIRE_DEFINE_VARIANT(name, draw, redeals) \
+    size_t listMoves_##name(Game *game, Move *moves) { return listMovesWith(game, moves, redeals); } \
+    void applyMove_##name(Game *game, Move move) { applyMoveWith(game, move, draw); }
+SOLITAIRE_VARIANTS(SOLITAIRE_DEFINE_VARIANT)
+
+void game_recycle_talon(Game *game)
+{
+    assert(game->reserve.count == 0);
+    while (game->talon.count > 0) {
+        Card c = pile_pop(game->cards, &game->talon);
+        c.revealed = false;
+        pile_append(game->cards, &game->reserve, c);
+    }
+    game->redeals++;
+}
+
+bool isWon(const Game *game)
+{
+    for (size_t i = 0; i < FOUNDATION_COLS; i++) {
+        if (game->foundation[i].count != 13) return false;
+    }
+    return true;
+}
+
+bool revealsCard(const Game *game, Move move)
+{
+    if (move.from.kind != PILE_TABLEAU || move.start == 0) return false;
+    return !game->cards[game->tableau[move.from.index].offset + move.start-1].revealed;
+}
+
+#endif // SOLITAIRE_IMPLEMENTATION
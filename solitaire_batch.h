@@ -0,0 +1,250 @@
+// solitaire_batch.h - move legality for GAME_BATCH games at once
+//
+// A Game_Batch holds only what the legality checks look at, the top card of
+// every foundation and tableau pile, as struct-of-arrays with one byte per
+// game: rank[pile][lane]. Given one candidate card per lane,
+// batch_accepts() answers "does this pile take it" for every pile and lane
+// with a handful of byte compares per pile, using AVX2, SSE2 or NEON when the
+// compiler targets them and plain loops otherwise.
+//
+// Piles are numbered in findMoveTarget() order (foundations, then tableau), so
+// the first accepting pile of a lane is the same target the game would pick.
+//
+// Define SOLITAIRE_BATCH_IMPLEMENTATION in exactly one translation unit before
+// including this header. Include solitaire.h first.
+#ifndef SOLITAIRE_BATCH_H_
+#define SOLITAIRE_BATCH_H_
+
+#ifndef SOLITAIRE_H_
+#error "include solitaire.h before solitaire_batch.h"
+#endif
+
+#define GAME_BATCH 16 // lanes, one byte each, so one 128-bit vector per pile
+#define BATCH_FOUNDATION 0
+#define BATCH_TABLEAU FOUNDATION_COLS
+#define BATCH_PILES (FOUNDATION_COLS + TABLEAU_COLS)
+#define BATCH_PILES_PADDED ((BATCH_PILES + 1) & ~1) // AVX2 does two piles per op
+#define BATCH_NO_CARD 0x80 // candidate rank for lanes with nothing to check
+
+typedef struct {
+    // top card per pile and lane; rank 0 means the pile is empty
+    uint8_t rank[BATCH_PILES_PADDED][GAME_BATCH];
+    uint8_t suit[BATCH_PILES_PADDED][GAME_BATCH];
+    uint8_t black[BATCH_PILES_PADDED][GAME_BATCH]; // 0xFF if black, 0 otherwise
+} Game_Batch;
+
+typedef struct {
+    uint8_t rank[GAME_BATCH];
+    uint8_t suit[GAME_BATCH];
+    uint8_t black[GAME_BATCH];  // 0xFF if black
+    uint8_t single[GAME_BATCH]; // 0xFF if the candidate is a lone card (only those go to a foundation)
+} Card_Batch;
+
+// name of the code path batch_accepts() was compiled for
+extern const char *batch_isa;
+
+void batch_clear(Game_Batch *b);
+void batch_load(Game_Batch *b, size_t lane, const Game *game);
+void batch_clear_candidates(Card_Batch *c);
+void batch_set_candidate(Card_Batch *c, size_t lane, Pile_View candidate);
+// accepts[pile] gets bit `lane` set if that pile takes the lane's candidate
+void batch_accepts(const Game_Batch *b, const Card_Batch *c, uint16_t accepts[BATCH_PILES]);
+// first accepting pile per lane, -1 if none; returns a mask of lanes that have one
+uint16_t batch_first_targets(const uint16_t accepts[BATCH_PILES], int8_t first[GAME_BATCH]);
+
+static inline Pile_Ref batch_pile_ref(int pile)
+{
+    if (pile < BATCH_TABLEAU) return CLITERAL(Pile_Ref) { PILE_FOUNDATION, pile - BATCH_FOUNDATION };
+    return CLITERAL(Pile_Ref) { PILE_TABLEAU, pile - BATCH_TABLEAU };
+}
+
+#endif // SOLITAIRE_BATCH_H_
+
+#ifdef SOLITAIRE_BATCH_IMPLEMENTATION
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void batch_clear(Game_Batch *b)
+{
+    memset(b, 0, sizeof(*b));
+    // the padding pile never accepts anything
+    for (size_t p = BATCH_PILES; p < BATCH_PILES_PADDED; p++) memset(b->rank[p], 0xFF, GAME_BATCH);
+}
+
+static inline void batch_set_top(Game_Batch *b, size_t pile, size_t lane, const Game *game, const Pile *p)
+{
+    if (p->count == 0) {
+        b->rank[pile][lane] = 0;
+        b->suit[pile][lane] = 0;
+        b->black[pile][lane] = 0;
+    } else {
+        Card c = pile_peek(game->cards, p);
+        b->rank[pile][lane] = c.value;
+        b->suit[pile][lane] = c.suit;
+        b->black[pile][lane] = is_black(c) ? 0xFF : 0;
+    }
+}
+
+void batch_load(Game_Batch *b, size_t lane, const Game *game)
+{
+    for (size_t i = 0; i < FOUNDATION_COLS; i++) batch_set_top(b, BATCH_FOUNDATION + i, lane, game, &game->foundation[i]);
+    for (size_t i = 0; i < TABLEAU_COLS; i++) batch_set_top(b, BATCH_TABLEAU + i, lane, game, &game->tableau[i]);
+}
+
+void batch_clear_candidates(Card_Batch *c)
+{
+    memset(c, 0, sizeof(*c));
+    memset(c->rank, BATCH_NO_CARD, sizeof(c->rank));
+}
+
+void batch_set_candidate(Card_Batch *c, size_t lane, Pile_View candidate)
+{
+    Card card = candidate.data[0];
+    c->rank[lane] = card.value;
+    c->suit[lane] = card.suit;
+    c->black[lane] = is_black(card) ? 0xFF : 0;
+    c->single[lane] = candidate.count == 1 ? 0xFF : 0;
+}
+
+// Foundation: rank is one above the top and either the suit matches or the
+// pile is empty (then rank-1 == 0 means an ace); only lone cards, except aces.
+// Tableau: colors differ and rank is one below the top, or a king onto an
+// empty pile. All of it is byte compares, so every ISA below is the same six
+// or seven ops per pile.
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+
+#if defined(__AVX2__)
+const char *batch_isa = "avx2";
+typedef __m256i Batch_Vec;
+#define BATCH_PILES_PER_VEC 2
+// same 16 candidate lanes in both halves, the halves hold two different piles
+#define bv_candidate(p) _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(p)))
+#define bv_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define bv_set1(x) _mm256_set1_epi8((char)(x))
+#define bv_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define bv_and(a, b) _mm256_and_si256(a, b)
+#define bv_or(a, b) _mm256_or_si256(a, b)
+#define bv_xor(a, b) _mm256_xor_si256(a, b)
+#define bv_add(a, b) _mm256_add_epi8(a, b)
+#define bv_sub(a, b) _mm256_sub_epi8(a, b)
+#define bv_mask(a) ((uint32_t)_mm256_movemask_epi8(a))
+#elif defined(__SSE2__)
+const char *batch_isa = "sse2";
+typedef __m128i Batch_Vec;
+#define BATCH_PILES_PER_VEC 1
+#define bv_candidate(p) _mm_loadu_si128((const __m128i *)(p))
+#define bv_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define bv_set1(x) _mm_set1_epi8((char)(x))
+#define bv_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define bv_and(a, b) _mm_and_si128(a, b)
+#define bv_or(a, b) _mm_or_si128(a, b)
+#define bv_xor(a, b) _mm_xor_si128(a, b)
+#define bv_add(a, b) _mm_add_epi8(a, b)
+#define bv_sub(a, b) _mm_sub_epi8(a, b)
+#define bv_mask(a) ((uint32_t)_mm_movemask_epi8(a))
+#else
+const char *batch_isa = "neon";
+typedef uint8x16_t Batch_Vec;
+#define BATCH_PILES_PER_VEC 1
+#define bv_candidate(p) vld1q_u8(p)
+#define bv_load(p) vld1q_u8(p)
+#define bv_set1(x) vdupq_n_u8(x)
+#define bv_eq(a, b) vceqq_u8(a, b)
+#define bv_and(a, b) vandq_u8(a, b)
+#define bv_or(a, b) vorrq_u8(a, b)
+#define bv_xor(a, b) veorq_u8(a, b)
+#define bv_add(a, b) vaddq_u8(a, b)
+#define bv_sub(a, b) vsubq_u8(a, b)
+// NEON has no movemask: keep one bit per byte, then add up each half
+static inline uint32_t bv_mask(uint8x16_t a)
+{
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t m = vandq_u8(a, vld1q_u8(bits));
+    return vaddv_u8(vget_low_u8(m)) | (uint32_t)vaddv_u8(vget_high_u8(m)) << 8;
+}
+#endif
+
+static inline void bv_store_accepts(uint16_t *accepts, size_t pile, uint32_t mask)
+{
+    accepts[pile] = (uint16_t)mask;
+#if BATCH_PILES_PER_VEC == 2
+    if (pile+1 < BATCH_PILES) accepts[pile+1] = (uint16_t)(mask >> 16);
+#endif
+}
+
+void batch_accepts(const Game_Batch *b, const Card_Batch *c, uint16_t accepts[BATCH_PILES])
+{
+    Batch_Vec one = bv_set1(1);
+    Batch_Vec zero = bv_set1(0);
+    Batch_Vec rank = bv_candidate(c->rank);
+    Batch_Vec suit = bv_candidate(c->suit);
+    Batch_Vec black = bv_candidate(c->black);
+    Batch_Vec below = bv_sub(rank, one);
+    Batch_Vec above = bv_add(rank, one);
+    Batch_Vec to_foundation = bv_or(bv_candidate(c->single), bv_eq(rank, one));
+    Batch_Vec king = bv_eq(rank, bv_set1(FACE_KING));
+
+    for (size_t p = BATCH_FOUNDATION; p < BATCH_TABLEAU; p += BATCH_PILES_PER_VEC) {
+        Batch_Vec top = bv_load(b->rank[p]);
+        Batch_Vec same_suit = bv_or(bv_eq(bv_load(b->suit[p]), suit), bv_eq(top, zero));
+        Batch_Vec ok = bv_and(bv_and(bv_eq(top, below), same_suit), to_foundation);
+        bv_store_accepts(accepts, p, bv_mask(ok));
+    }
+    for (size_t p = BATCH_TABLEAU; p < BATCH_PILES; p += BATCH_PILES_PER_VEC) {
+        Batch_Vec top = bv_load(b->rank[p]);
+        Batch_Vec stack = bv_and(bv_xor(bv_load(b->black[p]), black), bv_eq(top, above));
+        Batch_Vec ok = bv_or(stack, bv_and(bv_eq(top, zero), king));
+        bv_store_accepts(accepts, p, bv_mask(ok));
+    }
+}
+
+#else // scalar fallback
+
+const char *batch_isa = "scalar";
+
+void batch_accepts(const Game_Batch *b, const Card_Batch *c, uint16_t accepts[BATCH_PILES])
+{
+    for (size_t p = 0; p < BATCH_PILES; p++) {
+        uint16_t mask = 0;
+        for (size_t l = 0; l < GAME_BATCH; l++) {
+            uint8_t top = b->rank[p][l];
+            uint8_t rank = c->rank[l];
+            bool ok;
+            if (p < BATCH_TABLEAU) {
+                bool same_suit = b->suit[p][l] == c->suit[l] || top == 0;
+                ok = top == (uint8_t)(rank-1) && same_suit && (c->single[l] || rank == FACE_ACE);
+            } else {
+                ok = ((b->black[p][l] ^ c->black[l]) && top == (uint8_t)(rank+1)) || (top == 0 && rank == FACE_KING);
+            }
+            mask |= (uint16_t)ok << l;
+        }
+        accepts[p] = mask;
+    }
+}
+
+#endif
+
+uint16_t batch_first_targets(const uint16_t accepts[BATCH_PILES], int8_t first[GAME_BATCH])
+{
+    memset(first, -1, GAME_BATCH);
+    uint16_t pending = (uint16_t)((1u << GAME_BATCH) - 1);
+    for (int p = 0; p < BATCH_PILES && pending; p++) {
+        uint16_t hit = accepts[p] & pending;
+        pending &= ~hit;
+        while (hit) {
+            first[__builtin_ctz(hit)] = p;
+            hit &= hit - 1;
+        }
+    }
+    return (uint16_t)~pending;
+}
+
+#endif // SOLITAIRE_BATCH_IMPLEMENTATION
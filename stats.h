@@ -0,0 +1,231 @@
+// stats.h - lifetime game statistics
+//
+// Every finished game is appended to a log as one fixed-size record (seed,
+// time, moves, won), so the full per-seed history is kept and a torn write
+// costs at most the last record. Alongside it lives a summary: the running
+// aggregates plus how many bytes of the log they already cover. Opening the
+// database reads the summary and folds in only the log tail written since,
+// and the summary is rewritten every STATS_COMPACT_EVERY games, so opening
+// never costs more than that many records however long the history gets.
+//
+// Both files are little-endian regardless of the host. The summary is
+// written to a temporary file and renamed over the old one, so a crash
+// leaves either the old summary or the new one. They live in a directory the
+// caller names; on Android that has to be an absolute path such as the app's
+// internalDataPath, since raylib wraps fopen() to look there but rename() and
+// remove() would resolve a relative path against `/`.
+//
+// Define STATS_IMPLEMENTATION in exactly one translation unit before
+// including this header.
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATS_COMPACT_EVERY 32 // games between summary rewrites
+#define STATS_LOG_FILE "stats.log"
+#define STATS_SUMMARY_FILE "stats.sum"
+#define STATS_PATH_MAX 512
+
+typedef struct {
+    uint64_t seed;
+    uint32_t time_ms;  // from the deal to the win, or to giving up
+    uint16_t moves;
+    bool won;
+} Stats_Game;
+
+typedef struct {
+    uint32_t played;
+    uint32_t won;
+    uint32_t streak;           // wins in a row, up to the last game
+    uint32_t best_streak;
+    uint64_t win_time_ms;      // summed over won games
+    uint32_t fastest_win_ms;   // 0 until the first win
+    uint32_t fewest_win_moves; // 0 until the first win
+    uint64_t moves;            // summed over every game
+} Stats_Summary;
+
+typedef struct {
+    char log_path[STATS_PATH_MAX];
+    char summary_path[STATS_PATH_MAX];
+    Stats_Summary summary;
+    uint64_t log_bytes; // log length folded into `summary`
+    uint32_t pending;   // games logged since the summary file was written
+} Stats_Db;
+
+// loads the summary in `dir` and catches it up with the log there, creating
+// neither file; returns false only if the log exists but can't be read, or
+// `dir` is too long
+bool stats_open(Stats_Db *db, const char *dir);
+// appends the game to the log and folds it into the summary
+bool stats_record(Stats_Db *db, Stats_Game game);
+// writes the summary file now rather than at the next STATS_COMPACT_EVERY
+bool stats_compact(Stats_Db *db);
+void stats_fold(Stats_Summary *summary, Stats_Game game);
+
+#endif // STATS_H_
+
+#ifdef STATS_IMPLEMENTATION
+
+#include <stdio.h>
+#include <string.h>
+
+#define STATS_LOG_MAGIC "SLG1"
+#define STATS_SUMMARY_MAGIC "SSM1"
+#define STATS_HEADER_SIZE 4
+#define STATS_RECORD_SIZE 16 // seed:8 time_ms:4 moves:2 won:1 pad:1
+#define STATS_SUMMARY_SIZE (STATS_HEADER_SIZE + 8 + 4*6 + 8*2)
+
+static void stats_put(uint8_t *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> 8*i);
+}
+
+static uint64_t stats_get(const uint8_t *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint64_t)p[i] << 8*i;
+    return v;
+}
+
+void stats_fold(Stats_Summary *s, Stats_Game game)
+{
+    s->played++;
+    s->moves += game.moves;
+    if (!game.won) {
+        s->streak = 0;
+        return;
+    }
+    s->won++;
+    s->win_time_ms += game.time_ms;
+    if (s->fastest_win_ms == 0 || game.time_ms < s->fastest_win_ms) s->fastest_win_ms = game.time_ms;
+    if (s->fewest_win_moves == 0 || game.moves < s->fewest_win_moves) s->fewest_win_moves = game.moves;
+    if (++s->streak > s->best_streak) s->best_streak = s->streak;
+}
+
+static bool stats_load_summary(Stats_Db *db)
+{
+    FILE *f = fopen(db->summary_path, "rb");
+    if (!f) return false;
+    uint8_t buf[STATS_SUMMARY_SIZE];
+    bool ok = fread(buf, 1, sizeof buf, f) == sizeof buf && memcmp(buf, STATS_SUMMARY_MAGIC, STATS_HEADER_SIZE) == 0;
+    fclose(f);
+    if (!ok) return false;
+    const uint8_t *p = buf + STATS_HEADER_SIZE;
+    db->log_bytes                 = stats_get(p, 8); p += 8;
+    db->summary.played            = stats_get(p, 4); p += 4;
+    db->summary.won               = stats_get(p, 4); p += 4;
+    db->summary.streak            = stats_get(p, 4); p += 4;
+    db->summary.best_streak       = stats_get(p, 4); p += 4;
+    db->summary.fastest_win_ms    = stats_get(p, 4); p += 4;
+    db->summary.fewest_win_moves  = stats_get(p, 4); p += 4;
+    db->summary.win_time_ms       = stats_get(p, 8); p += 8;
+    db->summary.moves             = stats_get(p, 8); p += 8;
+    return true;
+}
+
+bool stats_compact(Stats_Db *db)
+{
+    uint8_t buf[STATS_SUMMARY_SIZE];
+    uint8_t *p = buf;
+    memcpy(p, STATS_SUMMARY_MAGIC, STATS_HEADER_SIZE); p += STATS_HEADER_SIZE;
+    stats_put(p, db->log_bytes, 8);                p += 8;
+    stats_put(p, db->summary.played, 4);           p += 4;
+    stats_put(p, db->summary.won, 4);              p += 4;
+    stats_put(p, db->summary.streak, 4);           p += 4;
+    stats_put(p, db->summary.best_streak, 4);      p += 4;
+    stats_put(p, db->summary.fastest_win_ms, 4);   p += 4;
+    stats_put(p, db->summary.fewest_win_moves, 4); p += 4;
+    stats_put(p, db->summary.win_time_ms, 8);      p += 8;
+    stats_put(p, db->summary.moves, 8);            p += 8;
+
+    char tmp_path[STATS_PATH_MAX + 4];
+    snprintf(tmp_path, sizeof tmp_path, "%s.tmp", db->summary_path);
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(buf, 1, sizeof buf, f) == sizeof buf;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp_path, db->summary_path) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    db->pending = 0;
+    return true;
+}
+
+bool stats_open(Stats_Db *db, const char *dir)
+{
+    *db = (Stats_Db) {0};
+    if (snprintf(db->log_path, STATS_PATH_MAX, "%s/" STATS_LOG_FILE, dir) >= STATS_PATH_MAX) return false;
+    if (snprintf(db->summary_path, STATS_PATH_MAX, "%s/" STATS_SUMMARY_FILE, dir) >= STATS_PATH_MAX) return false;
+    stats_load_summary(db);
+
+    FILE *f = fopen(db->log_path, "rb");
+    if (!f) {
+        // no games logged yet (or the log is gone, and a summary of it means nothing)
+        db->summary = (Stats_Summary) {0};
+        db->log_bytes = 0;
+        return true;
+    }
+    uint8_t header[STATS_HEADER_SIZE];
+    if (fread(header, 1, sizeof header, f) != sizeof header || memcmp(header, STATS_LOG_MAGIC, STATS_HEADER_SIZE) != 0) {
+        fclose(f);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    if (size < 0 || (uint64_t)size < db->log_bytes || db->log_bytes < STATS_HEADER_SIZE) {
+        // summary is from some other log, rebuild it from the whole history
+        db->summary = (Stats_Summary) {0};
+        db->log_bytes = STATS_HEADER_SIZE;
+    }
+    fseek(f, (long)db->log_bytes, SEEK_SET);
+    uint8_t rec[STATS_RECORD_SIZE];
+    while (fread(rec, 1, sizeof rec, f) == sizeof rec) {
+        stats_fold(&db->summary, (Stats_Game) {
+            .seed = stats_get(rec, 8),
+            .time_ms = stats_get(rec + 8, 4),
+            .moves = stats_get(rec + 12, 2),
+            .won = rec[14] != 0,
+        });
+        db->log_bytes += sizeof rec;
+        db->pending++;
+    }
+    // anything left over is a torn last record, the next append overwrites it
+    fclose(f);
+    if (db->pending >= STATS_COMPACT_EVERY) stats_compact(db);
+    return true;
+}
+
+bool stats_record(Stats_Db *db, Stats_Game game)
+{
+    // "r+b" so a torn tail record gets overwritten instead of shifting every record after it
+    FILE *f = fopen(db->log_path, "r+b");
+    if (!f) {
+        f = fopen(db->log_path, "wb");
+        if (!f) return false;
+        if (fwrite(STATS_LOG_MAGIC, 1, STATS_HEADER_SIZE, f) != STATS_HEADER_SIZE || fflush(f) != 0) {
+            fclose(f);
+            remove(db->log_path); // or the next open finds a log without its header
+            return false;
+        }
+        db->log_bytes = STATS_HEADER_SIZE;
+    }
+    uint8_t rec[STATS_RECORD_SIZE] = {0};
+    stats_put(rec, game.seed, 8);
+    stats_put(rec + 8, game.time_ms, 4);
+    stats_put(rec + 12, game.moves, 2);
+    rec[14] = game.won;
+    bool ok = fseek(f, (long)db->log_bytes, SEEK_SET) == 0 && fwrite(rec, 1, sizeof rec, f) == sizeof rec;
+    ok = fclose(f) == 0 && ok;
+    if (!ok) return false;
+
+    stats_fold(&db->summary, game);
+    db->log_bytes += sizeof rec;
+    if (++db->pending >= STATS_COMPACT_EVERY) stats_compact(db);
+    return true;
+}
+
+#endif // STATS_IMPLEMENTATION
@@ -0,0 +1,94 @@
+// Host test for stats.h, built and run by `./nob test`.
+//
+// Plays games into a database in a scratch directory and checks that
+// reopening it after a compaction folds in only the log tail: the records
+// the summary already covers are scribbled over, and the totals must not move.
+#define STATS_IMPLEMENTATION
+#include "stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TAIL_GAMES 5 // logged after the automatic compaction
+
+static int failures;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static Stats_Game game_at(uint32_t i)
+{
+    return (Stats_Game) { .seed = 1000 + i, .time_ms = 60000 + 1000*i, .moves = (uint16_t)(100 + i), .won = i % 3 != 0 };
+}
+
+static bool summary_eq(const Stats_Summary *a, const Stats_Summary *b)
+{
+    return a->played == b->played && a->won == b->won && a->streak == b->streak &&
+           a->best_streak == b->best_streak && a->win_time_ms == b->win_time_ms &&
+           a->fastest_win_ms == b->fastest_win_ms && a->fewest_win_moves == b->fewest_win_moves &&
+           a->moves == b->moves;
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/stats-test-XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    Stats_Db db;
+    Stats_Summary want = {0};
+    CHECK(stats_open(&db, dir));
+    CHECK(db.summary.played == 0);
+    uint32_t games = STATS_COMPACT_EVERY + TAIL_GAMES;
+    for (uint32_t i = 0; i < games; i++) {
+        CHECK(stats_record(&db, game_at(i)));
+        stats_fold(&want, game_at(i));
+    }
+    CHECK(db.pending == TAIL_GAMES);
+    CHECK(summary_eq(&db.summary, &want));
+
+    // only the tail is folded in again
+    Stats_Db reopened;
+    CHECK(stats_open(&reopened, dir));
+    CHECK(reopened.pending == TAIL_GAMES);
+    CHECK(reopened.log_bytes == db.log_bytes);
+    CHECK(summary_eq(&reopened.summary, &want));
+
+    // so garbage in the part the summary covers changes nothing
+    FILE *f = fopen(db.log_path, "r+b");
+    CHECK(f != NULL);
+    if (f) {
+        uint8_t garbage[STATS_COMPACT_EVERY*STATS_RECORD_SIZE];
+        memset(garbage, 0xAB, sizeof garbage);
+        CHECK(fseek(f, STATS_HEADER_SIZE, SEEK_SET) == 0);
+        CHECK(fwrite(garbage, 1, sizeof garbage, f) == sizeof garbage);
+        fclose(f);
+    }
+    CHECK(stats_open(&reopened, dir));
+    CHECK(reopened.pending == TAIL_GAMES);
+    CHECK(summary_eq(&reopened.summary, &want));
+
+    // without the summary the whole log is read, garbage and all
+    CHECK(remove(db.summary_path) == 0);
+    CHECK(stats_open(&reopened, dir));
+    CHECK(reopened.summary.played == games);
+    CHECK(!summary_eq(&reopened.summary, &want));
+
+    remove(db.log_path);
+    remove(db.summary_path); // the reopen above compacted again
+    rmdir(dir);
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("stats: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,408 @@
+// Monte Carlo simulator: plays many deals with a fixed move policy under one
+// of the Klondike rule variants in solitaire.h or one of the games in board.h
+// and reports win rates and move-count histograms. Built and run by
+// `./nob sim [options]`.
+//
+// Games are split across threads in contiguous ranges. Game `g` is dealt from
+// seed+g and its policy draws from its own splitmix stream derived from the
+// same number, so results don't depend on the thread count.
+#define SOLITAIRE_IMPLEMENTATION
+#include "solitaire.h"
+#define BOARD_IMPLEMENTATION
+#include "board.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HIST_BUCKET 25 // moves per histogram bucket
+#define HIST_BUCKETS 64
+#define MAX_THREADS 256
+
+typedef size_t (*Policy_Fn)(Game *game, const Move *moves, size_t n, uint64_t *rng);
+typedef size_t (*Board_Policy_Fn)(Board *board, const Board_Rules *rules, const Board_Move *moves, size_t n, uint64_t *rng);
+
+typedef struct {
+    const char *name;
+    Policy_Fn pick;
+    Board_Policy_Fn pick_board;
+} Policy;
+
+typedef struct {
+    uint64_t games;
+    uint64_t wins;
+    uint64_t moves;
+    uint64_t hist_all[HIST_BUCKETS];
+    uint64_t hist_won[HIST_BUCKETS];
+} Sim_Stats;
+
+typedef struct Sim_Job Sim_Job;
+typedef int (*Play_Fn)(const Sim_Job *job, uint64_t g, bool *won);
+
+typedef struct {
+    const char *name;
+    Play_Fn play;
+} Rules;
+
+struct Sim_Job {
+    const Policy *policy;
+    const Rules *rules;
+    uint64_t seed;
+    uint64_t first_game;
+    uint64_t game_count;
+    int max_moves;
+    int stall_moves;
+    Sim_Stats stats;
+};
+
+static size_t pickRandom(Game *game, const Move *moves, size_t n, uint64_t *rng)
+{
+    (void) game;
+    (void) moves;
+    return rng_below(rng, n);
+}
+
+// foundation first, then moves that turn a card over or clear a column, then
+// talon plays, then drawing; never undoes its own progress. Ties are broken at random.
+static size_t pickGreedy(Game *game, const Move *moves, size_t n, uint64_t *rng)
+{
+    int best_score = 0;
+    size_t best = n;
+    size_t ties = 0;
+    for (size_t i = 0; i < n; i++) {
+        Move m = moves[i];
+        int score = 0;
+        if (m.to.kind == PILE_FOUNDATION && m.from.kind != PILE_FOUNDATION) {
+            score = 5;
+        } else if (m.from.kind == PILE_TABLEAU && m.to.kind == PILE_TABLEAU) {
+            Card c = pile_cards(game->cards, &game->tableau[m.from.index])[m.start];
+            if (revealsCard(game, m) || (m.start == 0 && c.value != FACE_KING)) score = 4;
+        } else if (m.from.kind == PILE_TALON && m.to.kind != PILE_RESERVE) {
+            score = 3;
+        } else if (m.to.kind == PILE_TALON || m.to.kind == PILE_RESERVE) {
+            score = 1;
+        }
+        if (score > best_score) {
+            best_score = score;
+            best = i;
+            ties = 1;
+        } else if (score == best_score && score > 0 && rng_below(rng, ++ties) == 0) {
+            best = i; // reservoir sampling over the ties
+        }
+    }
+    return best;
+}
+
+static size_t pickBoardRandom(Board *board, const Board_Rules *rules, const Board_Move *moves, size_t n, uint64_t *rng)
+{
+    (void) board;
+    (void) rules;
+    (void) moves;
+    return rng_below(rng, n);
+}
+
+static bool boardRevealsCard(const Board *board, const Board_Rules *rules, Board_Move m)
+{
+    if (m.kind != BMOVE_RUN || m.from >= rules->tableau || m.start == 0) return false;
+    return !(board_pile_cards(board, m.from)[m.start-1] & BCARD_UP);
+}
+
+// the same order of preference as pickGreedy(), plus: build in suit (which is
+// what Spider needs), park cards in FreeCell cells only as a last resort. A run
+// already sitting on a card it builds on is only moved to turn a card over or
+// to go onto its own suit, otherwise the policy shuffles it back and forth.
+static size_t pickBoardGreedy(Board *board, const Board_Rules *rules, const Board_Move *moves, size_t n, uint64_t *rng)
+{
+    int best_score = 0;
+    size_t best = n;
+    size_t ties = 0;
+    for (size_t i = 0; i < n; i++) {
+        Board_Move m = moves[i];
+        bool from_tableau = m.from < rules->tableau;
+        bool to_tableau = m.to < rules->tableau;
+        int score = 0;
+        if (m.kind != BMOVE_RUN) {
+            score = 1;
+        } else if (m.to >= board_first_foundation(rules) && m.to < board_first_cell(rules)) {
+            score = 6;
+        } else if (from_tableau && to_tableau) {
+            const Pile *dst = &board->piles[m.to];
+            const Board_Card *src = board_pile_cards(board, m.from);
+            Board_Card c = src[m.start];
+            Board_Card below = m.start > 0 ? src[m.start-1] : 0;
+            bool built = (below & BCARD_UP) && board_builds(rules->build, c, below);
+            bool in_suit = (below & BCARD_UP) && board_builds(BUILD_SAME_SUIT, c, below);
+            if (boardRevealsCard(board, rules, m)) score = 5;
+            else if (dst->count == 0) score = rules->stock == STOCK_DEAL_ROW ? 1 : 0; // Spider can't deal with a column empty
+            else if (!in_suit && BCARD_SUIT(c) == BCARD_SUIT(board_pile_cards(board, m.to)[dst->count-1])) score = 4;
+            else if (m.start == 0) score = 3; // empties a column
+            else if (!built) score = 2;
+        } else if (to_tableau) {
+            score = 4; // from a cell
+        } else {
+            score = 1; // into a cell
+        }
+        if (score > best_score) {
+            best_score = score;
+            best = i;
+            ties = 1;
+        } else if (score == best_score && score > 0 && rng_below(rng, ++ties) == 0) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static const Policy policies[] = {
+    { "random", pickRandom, pickBoardRandom },
+    { "greedy", pickGreedy, pickBoardGreedy },
+};
+
+// returns the number of moves played, `won` tells how it ended. Always
+// inlined into one playGame_<variant>() per rule variant, where `list` and
+// `apply` are constants, so the loop calls the variant's rules directly.
+static inline __attribute__((always_inline))
+int playGameWith(const Sim_Job *job, uint64_t g, bool *won,
+                 size_t (*list)(Game *, Move *), void (*apply)(Game *, Move))
+{
+    Game game;
+    Move moves[MAX_MOVES];
+    uint64_t rng = (job->seed + g) ^ 0xD1B54A32D192ED03ull;
+    dealGame(&game, job->seed + g);
+    int played = 0;
+    int progress_at = 0;
+    int foundation_cards = 0, best_foundation_cards = 0;
+    while (played < job->max_moves && played - progress_at < job->stall_moves) {
+        size_t n = list(&game, moves);
+        if (n == 0) break;
+        size_t pick = job->policy->pick(&game, moves, n, &rng);
+        if (pick >= n) break; // policy gave up
+        Move m = moves[pick];
+        // progress is a card turned over or a new high on the foundations,
+        // anything else can be undone and cycle forever
+        bool progress = revealsCard(&game, m);
+        if (m.to.kind == PILE_FOUNDATION) foundation_cards++;
+        if (m.from.kind == PILE_FOUNDATION) foundation_cards--;
+        if (foundation_cards > best_foundation_cards) {
+            best_foundation_cards = foundation_cards;
+            progress = true;
+        }
+        apply(&game, m);
+        played++;
+        if (progress) progress_at = played;
+        if (foundation_cards == DECK_CARDS) break;
+    }
+    *won = isWon(&game);
+    return played;
+}
+
+#define SIM_DEFINE_VARIANT(name, draw, redeals) \
+    static int playGame_##name(const Sim_Job *job, uint64_t g, bool *won) \
+    { return playGameWith(job, g, won, listMoves_##name, applyMove_##name); }
+SOLITAIRE_VARIANTS(SIM_DEFINE_VARIANT)
+
+// playGameWith() for the board.h games
+static inline __attribute__((always_inline))
+int playBoardWith(const Sim_Job *job, uint64_t g, bool *won, const Board_Rules *rules,
+                  size_t (*list)(Board *, Board_Move *), void (*apply)(Board *, Board_Move))
+{
+    Board board;
+    Board_Move moves[BOARD_MAX_MOVES];
+    uint64_t rng = (job->seed + g) ^ 0xD1B54A32D192ED03ull;
+    dealBoard(&board, rules, job->seed + g);
+    int played = 0;
+    int progress_at = 0;
+    int best_foundation_cards = 0;
+    while (played < job->max_moves && played - progress_at < job->stall_moves) {
+        size_t n = list(&board, moves);
+        if (n == 0) break;
+        size_t pick = job->policy->pick_board(&board, rules, moves, n, &rng);
+        if (pick >= n) break;
+        bool progress = boardRevealsCard(&board, rules, moves[pick]);
+        apply(&board, moves[pick]);
+        played++;
+        int foundation_cards = 0;
+        for (int f = 0; f < rules->foundations; f++) foundation_cards += board.piles[board_first_foundation(rules) + f].count;
+        if (foundation_cards > best_foundation_cards) {
+            best_foundation_cards = foundation_cards;
+            progress = true;
+        }
+        if (progress) progress_at = played;
+        if (foundation_cards == 52*rules->decks) break;
+    }
+    *won = isBoardWon(&board, rules);
+    return played;
+}
+
+#define SIM_DEFINE_BOARD_VARIANT(name) \
+    static int playBoard_##name(const Sim_Job *job, uint64_t g, bool *won) \
+    { return playBoardWith(job, g, won, &board_rules_##name, listBoardMoves_##name, applyBoardMove_##name); }
+BOARD_VARIANTS(SIM_DEFINE_BOARD_VARIANT)
+
+#define SIM_RULES_ENTRY(name, draw, redeals) { #name, playGame_##name },
+#define SIM_BOARD_RULES_ENTRY(name) { #name, playBoard_##name },
+static const Rules rules_variants[] = {
+    SOLITAIRE_VARIANTS(SIM_RULES_ENTRY)
+    BOARD_VARIANTS(SIM_BOARD_RULES_ENTRY)
+};
+
+static void *simThread(void *arg)
+{
+    Sim_Job *job = arg;
+    Sim_Stats *s = &job->stats;
+    for (uint64_t g = job->first_game; g < job->first_game + job->game_count; g++) {
+        bool won;
+        int moves = job->rules->play(job, g, &won);
+        size_t bucket = moves/HIST_BUCKET;
+        if (bucket >= HIST_BUCKETS) bucket = HIST_BUCKETS-1;
+        s->games++;
+        s->moves += moves;
+        s->hist_all[bucket]++;
+        if (won) {
+            s->wins++;
+            s->hist_won[bucket]++;
+        }
+    }
+    return NULL;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static void printHistogram(const char *title, const uint64_t *hist, uint64_t total)
+{
+    if (total == 0) return;
+    uint64_t peak = 0;
+    size_t first = HIST_BUCKETS, last = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; i++) {
+        if (hist[i] > peak) peak = hist[i];
+        if (hist[i] && first == HIST_BUCKETS) first = i;
+        if (hist[i]) last = i;
+    }
+    printf("  %s\n", title);
+    for (size_t i = first; i <= last; i++) {
+        int bar = (int)(40*hist[i]/peak);
+        printf("    %5zu%s %6.2f%% %.*s\n", i*HIST_BUCKET, i == HIST_BUCKETS-1 ? "+" : " ",
+               100.0*hist[i]/total, bar, "########################################");
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--games N] [--threads N] [--policy random|greedy|all] [--rules draw1|draw3|draw1_vegas|draw3_vegas|freecell|spider1|spider2|spider4] [--seed N] [--max-moves N] [--stall N] [--hist]\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t games = 1000000;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *policy_name = "all";
+    const char *rules_name = "draw1";
+    uint64_t seed = 1;
+    int max_moves = 1000;
+    int stall_moves = 150; // a full pass through the reserve and back is at most 50
+    bool hist = false;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i+1 < argc ? argv[i+1] : NULL;
+        if (strcmp(arg, "--hist") == 0) {
+            hist = true;
+            continue;
+        }
+        if (!val) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--games") == 0) games = strtoull(val, NULL, 0);
+        else if (strcmp(arg, "--threads") == 0) threads = atol(val);
+        else if (strcmp(arg, "--policy") == 0) policy_name = val;
+        else if (strcmp(arg, "--rules") == 0) rules_name = val;
+        else if (strcmp(arg, "--seed") == 0) seed = strtoull(val, NULL, 0);
+        else if (strcmp(arg, "--max-moves") == 0) max_moves = atoi(val);
+        else if (strcmp(arg, "--stall") == 0) stall_moves = atoi(val);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    const Rules *rules = NULL;
+    for (size_t r = 0; r < sizeof(rules_variants)/sizeof(*rules_variants); r++) {
+        if (strcmp(rules_name, rules_variants[r].name) == 0) rules = &rules_variants[r];
+    }
+    if (games < 1) {
+        fprintf(stderr, "--games must be at least 1\n");
+        usage(argv[0]);
+        return 1;
+    }
+    if (!rules) {
+        fprintf(stderr, "Unknown rules: %s\n", rules_name);
+        usage(argv[0]);
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    bool any = false;
+    for (size_t p = 0; p < sizeof(policies)/sizeof(*policies); p++) {
+        if (strcmp(policy_name, "all") != 0 && strcmp(policy_name, policies[p].name) != 0) continue;
+        any = true;
+
+        static Sim_Job jobs[MAX_THREADS];
+        static pthread_t tids[MAX_THREADS];
+        double start = now_seconds();
+        for (long t = 0; t < threads; t++) {
+            jobs[t] = (Sim_Job) {
+                .policy = &policies[p],
+                .rules = rules,
+                .seed = seed,
+                .first_game = games*t/threads,
+                .game_count = games*(t+1)/threads - games*t/threads,
+                .max_moves = max_moves,
+                .stall_moves = stall_moves,
+            };
+            if (pthread_create(&tids[t], NULL, simThread, &jobs[t]) != 0) {
+                fprintf(stderr, "Could not start simulation thread\n");
+                return 1;
+            }
+        }
+        Sim_Stats total = {0};
+        for (long t = 0; t < threads; t++) {
+            pthread_join(tids[t], NULL);
+            Sim_Stats *s = &jobs[t].stats;
+            total.games += s->games;
+            total.wins += s->wins;
+            total.moves += s->moves;
+            for (size_t i = 0; i < HIST_BUCKETS; i++) {
+                total.hist_all[i] += s->hist_all[i];
+                total.hist_won[i] += s->hist_won[i];
+            }
+        }
+        double elapsed = now_seconds() - start;
+
+        double rate = (double)total.wins/total.games;
+        printf("%s/%s: %llu/%llu won (%.3f%% +- %.3f%%), %.1f moves/game\n", policies[p].name, rules->name,
+               (unsigned long long)total.wins, (unsigned long long)total.games,
+               100.0*rate, 100.0*1.96*sqrt(rate*(1.0-rate)/total.games), (double)total.moves/total.games);
+        printf("  %.2fs on %ld threads, %.0f games/s, %.2f M moves/s per thread\n",
+               elapsed, threads, total.games/elapsed, total.moves/elapsed/threads/1e6);
+        if (hist) {
+            printHistogram("moves per game, all games:", total.hist_all, total.games);
+            printHistogram("moves per game, won games:", total.hist_won, total.wins);
+        }
+    }
+    if (!any) {
+        fprintf(stderr, "Unknown policy: %s\n", policy_name);
+        usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// trace.h - scoped trace events with Chrome/Perfetto JSON export
+//
+// TRACE_BEGIN(name)/TRACE_END() bracket a named scope. Each thread records
+// its completed events into fixed-size buffers of its own, so recording is a
+// clock read plus a couple of stores with no locking and no allocation after
+// the thread's first event. The first TRACE_FIRST_EVENTS events of each thread
+// are kept for good, which is startup and the first texture loads, and after
+// that a ring keeps the most recent TRACE_EVENTS_PER_THREAD.
+//
+// trace_write_json() exports everything recorded so far in the Chrome trace
+// event format, which loads in chrome://tracing and ui.perfetto.dev.
+//
+// Define TRACE_IMPLEMENTATION in exactly one translation unit before
+// including this header. Build with TRACE_ENABLED=0 to compile all scopes out.
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_FIRST_EVENTS 4096       // never overwritten
+#define TRACE_EVENTS_PER_THREAD 16384 // ring after those, must be a power of two
+#define TRACE_MAX_DEPTH 32
+
+// `name` must outlive the trace, in practice a string literal
+void trace_begin(const char *name);
+void trace_end(void);
+bool trace_write_json(const char *path);
+
+#if TRACE_ENABLED
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END() trace_end()
+#else
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END() ((void)0)
+#endif
+
+#endif // TRACE_H_
+
+#ifdef TRACE_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+} Trace_Event;
+
+typedef struct Trace_Buffer {
+    Trace_Event first[TRACE_FIRST_EVENTS];
+    Trace_Event events[TRACE_EVENTS_PER_THREAD];
+    uint64_t written; // event `i` is first[i] below TRACE_FIRST_EVENTS, in the ring from there on
+    struct {
+        const char *name;
+        uint64_t start_ns;
+    } stack[TRACE_MAX_DEPTH];
+    int depth;
+    int tid;
+    struct Trace_Buffer *next;
+} Trace_Buffer;
+
+// every thread that ever recorded an event, newest first
+static Trace_Buffer *trace_buffers = NULL;
+static int trace_thread_count = 0;
+static __thread Trace_Buffer *trace_tls = NULL;
+
+static uint64_t trace_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+static Trace_Buffer *trace_thread_buffer(void)
+{
+    if (trace_tls) return trace_tls;
+    Trace_Buffer *b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    b->tid = __atomic_add_fetch(&trace_thread_count, 1, __ATOMIC_RELAXED);
+    b->next = __atomic_load_n(&trace_buffers, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_buffers, &b->next, b, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    trace_tls = b;
+    return b;
+}
+
+void trace_begin(const char *name)
+{
+    Trace_Buffer *b = trace_thread_buffer();
+    if (!b) return;
+    if (b->depth < TRACE_MAX_DEPTH) {
+        b->stack[b->depth].name = name;
+        b->stack[b->depth].start_ns = trace_now_ns();
+    }
+    b->depth++;
+}
+
+void trace_end(void)
+{
+    Trace_Buffer *b = trace_tls;
+    if (!b || b->depth == 0) return;
+    b->depth--;
+    if (b->depth >= TRACE_MAX_DEPTH) return;
+    uint64_t n = b->written;
+    Trace_Event *e = n < TRACE_FIRST_EVENTS ? &b->first[n] : &b->events[n & (TRACE_EVENTS_PER_THREAD-1)];
+    e->name = b->stack[b->depth].name;
+    e->start_ns = b->stack[b->depth].start_ns;
+    e->dur_ns = trace_now_ns() - e->start_ns;
+    __atomic_store_n(&b->written, n+1, __ATOMIC_RELEASE);
+}
+
+// NOTE: other threads may keep recording while we export, the newest events
+// of a busy thread can be torn; fine for a debugging dump
+bool trace_write_json(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (Trace_Buffer *b = __atomic_load_n(&trace_buffers, __ATOMIC_ACQUIRE); b; b = b->next) {
+        uint64_t end = __atomic_load_n(&b->written, __ATOMIC_ACQUIRE);
+        // the first events, then whatever of the rest the ring still has
+        uint64_t ring_start = end > TRACE_FIRST_EVENTS + TRACE_EVENTS_PER_THREAD ? end - TRACE_EVENTS_PER_THREAD : TRACE_FIRST_EVENTS;
+        for (uint64_t i = 0; i < end; i++) {
+            if (i == TRACE_FIRST_EVENTS) i = ring_start;
+            if (i >= end) break;
+            const Trace_Event *e = i < TRACE_FIRST_EVENTS ? &b->first[i] : &b->events[i & (TRACE_EVENTS_PER_THREAD-1)];
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", e->name, b->tid, e->start_ns/1000.0, e->dur_ns/1000.0);
+            first = false;
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+    return true;
+}
+
+#endif // TRACE_IMPLEMENTATION